@@ -42,6 +42,21 @@
 #define CLAY_WASM_EXPORT(null)
 #endif
 
+// Clay's current context is thread local, so that separate threads can each lay out their own context at the same time
+#if defined(CLAY_WASM)
+#define CLAY__THREAD_LOCAL
+#elif defined(__cplusplus)
+#define CLAY__THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define CLAY__THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define CLAY__THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define CLAY__THREAD_LOCAL __thread
+#else
+#define CLAY__THREAD_LOCAL
+#endif
+
 // Public Macro API ------------------------
 
 #define CLAY__MAX(x, y) (((x) > (y)) ? (x) : (y))
@@ -82,7 +97,7 @@
 
 #define CLAY_STRING_CONST(string) { .length = CLAY__STRING_LENGTH(CLAY__ENSURE_STRING_LITERAL(string)), .chars = (string) }
 
-static uint8_t CLAY__ELEMENT_DEFINITION_LATCH;
+static CLAY__THREAD_LOCAL uint8_t CLAY__ELEMENT_DEFINITION_LATCH;
 
 // Publicly visible layout element macros -----------------------------------------------------
 
@@ -664,6 +679,75 @@ typedef struct {
     Clay_RenderCommand* internalArray;
 } Clay_RenderCommandArray;
 
+// The difference between the render commands of the two most recent frames, returned by Clay_GetRenderCommandDiff().
+// Commands are matched between frames by their id and command type.
+typedef struct {
+    // Commands from this frame with no matching command in the previous frame.
+    Clay_RenderCommandArray added;
+    // Commands from this frame whose bounding box, render data, user data or z index differ from the matching command in the previous frame.
+    Clay_RenderCommandArray changed;
+    // Copies of the previous frame's version of each command in changed, at the same index.
+    // Pointers they hold may no longer be valid, as with removed.
+    Clay_RenderCommandArray changedPrevious;
+    // Copies of commands from the previous frame with no matching command in this frame.
+    // Pointers they hold, such as text contents, may no longer be valid, but bounding boxes can always be used to work out what to redraw.
+    Clay_RenderCommandArray removed;
+} Clay_RenderCommandDiff;
+
+// An 8 bit per channel color, with the same layout as most renderers' own color types.
+typedef struct {
+    uint8_t r, g, b, a;
+} Clay_PackedColor;
+
+// A compact, 32 byte version of Clay_RenderCommand. Returned by Clay_GetPackedRenderCommands() when packed render commands are enabled.
+// Anything that doesn't fit, such as text contents, image data and user data, is stored in the stream's data table.
+typedef struct {
+    // The bounding box, rounded to whole pixels and clamped to the range of int16_t.
+    int16_t x, y, width, height;
+    uint32_t id;
+    // backgroundColor for rectangles, images and custom commands, textColor for text, color for borders.
+    Clay_PackedColor color;
+    // topLeft, topRight, bottomLeft and bottomRight, rounded and clamped to 255.
+    uint8_t cornerRadius[4];
+    // Index into Clay_PackedRenderCommandStream.data, or -1 if this command has no data there.
+    int32_t dataIndex;
+    int16_t zIndex;
+    // A Clay_RenderCommandType.
+    uint8_t commandType;
+    // Scissor start commands only: bit 0 is set if the scroll container scrolls horizontally, bit 1 if it scrolls vertically.
+    uint8_t scrollFlags;
+    union {
+        struct {
+            uint16_t fontId;
+            uint16_t fontSize;
+        } text;
+        // left, right, top and bottom, clamped to 255.
+        uint8_t borderWidth[4];
+    } renderData;
+} Clay_PackedRenderCommand;
+
+// The side table entry for packed render commands with data that doesn't fit in 32 bytes.
+typedef struct {
+    // Text only.
+    Clay_StringSlice stringContents;
+    // The imageData of image commands, or the customData of custom commands.
+    void *data;
+    // Image only.
+    Clay_Dimensions sourceDimensions;
+    void *userData;
+    // Text only.
+    uint16_t letterSpacing;
+    uint16_t lineHeight;
+} Clay_PackedRenderCommandData;
+
+// The render commands of the most recent frame, packed into one contiguous stream plus a data table.
+typedef struct {
+    int32_t length;
+    Clay_PackedRenderCommand *commands;
+    int32_t dataLength;
+    Clay_PackedRenderCommandData *data;
+} Clay_PackedRenderCommandStream;
+
 // Represents the current state of interaction with clay this frame.
 typedef CLAY_PACKED_ENUM {
     // A left mouse click, or touch occurred this frame.
@@ -717,6 +801,21 @@ typedef struct {
 
 CLAY__WRAPPER_STRUCT(Clay_ElementDeclaration);
 
+// Controls the rows of a list declared with Clay_VirtualList().
+typedef struct {
+    // The total number of rows in the list.
+    int32_t rowCount;
+    // The height of each row. Used to work out which rows are visible, and to stand in for the height of rows that aren't declared.
+    // Rows that are declared with a different height still lay out correctly, but the list's content size is then only an estimate.
+    float rowHeight;
+    // The number of extra rows to declare above and below the visible ones, e.g. to keep rows declared while they scroll into view.
+    int32_t overscanRowCount;
+    // Called once for each row that needs declaring, in order. Should declare exactly one element for the row, usually sized to rowHeight.
+    void (*declareRow)(int32_t rowIndex, void *userData);
+    // A pointer that will be transparently passed through when declareRow is called.
+    void *userData;
+} Clay_VirtualListConfig;
+
 // Represents the type of error clay encountered while computing layout.
 typedef CLAY_PACKED_ENUM {
     // A text measurement function wasn't provided using Clay_SetMeasureTextFunction(), or the provided function was null.
@@ -769,6 +868,7 @@ typedef struct {
 // Public API functions ------------------------------------------
 
 // Returns the size, in bytes, of the minimum amount of memory Clay requires to operate at its current settings.
+// Opt-in features such as retained layout, render command diffing and packed render commands are only counted once enabled on the current context.
 uint32_t Clay_MinMemorySize(void);
 // Creates an arena for clay to use for its internal allocations, given a certain capacity in bytes and a pointer to an allocation of at least that size.
 // Intended to be used with Clay_MinMemorySize in the following way:
@@ -783,10 +883,17 @@ void Clay_SetPointerState(Clay_Vector2 position, bool pointerDown);
 // - layoutDimensions are the initial bounding dimensions of the layout (i.e. the screen width and height for a full screen layout)
 // - errorHandler is used by Clay to inform you if something has gone wrong in configuration or layout.
 Clay_Context* Clay_Initialize(Clay_Arena arena, Clay_Dimensions layoutDimensions, Clay_ErrorHandler errorHandler);
-// Returns the Context that clay is currently using. Used when using multiple instances of clay simultaneously.
+// Moves the current context into a new arena, applying any changes made with Clay_SetMaxElementCount(), Clay_SetMaxMeasureTextCacheWordCount()
+// or Clay_SetMaxScrollContainerCount() without discarding the element hash map, the text measurement cache or scroll positions.
+// - arena must have a capacity of at least Clay_MinMemorySize(), called after changing the max counts.
+// - Call between frames, ideally just before Clay_BeginLayout(). The memory backing the previous arena can be freed once this returns.
+// Returns the new context, which also becomes the current context, or NULL if the arena is too small to hold it.
+Clay_Context* Clay_ResizeContext(Clay_Arena arena);
+// Returns the Context that clay is currently using on the calling thread. Used when using multiple instances of clay simultaneously.
 Clay_Context* Clay_GetCurrentContext(void);
-// Sets the context that clay will use to compute the layout.
+// Sets the context that clay will use to compute the layout on the calling thread.
 // Used to restore a context saved from Clay_GetCurrentContext when using multiple instances of clay simultaneously.
+// The current context is thread local: each thread that calls into clay must set its own, and different threads may lay out different contexts at the same time.
 void Clay_SetCurrentContext(Clay_Context* context);
 // Updates the state of Clay's internal scroll data, updating scroll content positions if scrollDelta is non zero, and progressing momentum scrolling.
 // - enableDragScrolling when set to true will enable mobile device like "touch drag" scroll of scroll containers, including momentum scrolling after the touch has ended.
@@ -809,6 +916,7 @@ Clay_ElementId Clay_GetElementId(Clay_String idString);
 Clay_ElementId Clay_GetElementIdWithIndex(Clay_String idString, uint32_t index);
 // Returns layout data such as the final calculated bounding box for an element with a given ID.
 // The returned Clay_ElementData contains a `found` bool that will be true if an element with the provided ID was found.
+// Elements inside an offscreen subtree that culling skipped keep the bounding box from the last layout that positioned them.
 // This ID can be calculated either with CLAY_ID() for string literal IDs, or Clay_GetElementId for dynamic strings.
 Clay_ElementData Clay_GetElementData(Clay_ElementId id);
 // Returns true if the pointer position provided by Clay_SetPointerState is within the current element's bounding box.
@@ -826,13 +934,26 @@ bool Clay_PointerOver(Clay_ElementId elementId);
 // An imperative function that returns true if the pointer position provided by Clay_SetPointerState is within the element with the provided ID's bounding box.
 // This ID can be calculated either with CLAY_ID() for string literal IDs, or Clay_GetElementId for dynamic strings.
 Clay_ScrollContainerData Clay_GetScrollContainerData(Clay_ElementId id);
+// Declares a vertically scrolling list element whose rows are only declared while they are visible.
+// - declaration configures the list element itself, and is always laid out top to bottom with vertical scrolling enabled. Its .layout.childGap separates rows.
+// - config gives the number and height of the rows, and the callback used to declare each visible row.
+// Rows outside the visible range are replaced by spacers, so the list's content size, scrollbars and momentum scrolling behave as if every row were declared.
+// The visible range comes from the list's scroll position and from its height in the previous frame, so give the list a stable id.
+void Clay_VirtualList(Clay_ElementDeclaration declaration, Clay_VirtualListConfig config);
 // Binds a callback function that Clay will call to determine the dimensions of a given string slice.
 // - measureTextFunction is a user provided function that adheres to the interface Clay_Dimensions (Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
 // - userData is a pointer that will be transparently passed through when the measureTextFunction is called.
+// The function is stored on the current context, and contexts created later with Clay_Initialize() start out with the same one.
 void Clay_SetMeasureTextFunction(Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData), void *userData);
 // Experimental - Used in cases where Clay needs to integrate with a system that manages its own scrolling containers externally.
 // Please reach out if you plan to use this function, as it may be subject to change.
 void Clay_SetQueryScrollOffsetFunction(Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData), void *userData);
+// Binds a callback function that Clay will use to spread independent layout work, such as wrapping text elements, across threads.
+// - parallelForFunction must call job(index, jobData) exactly once for every index in [0, jobCount), in any order and on any thread, and return once all calls have finished.
+// - Jobs never call the text measurement function or the error handler, so neither needs to be thread safe.
+// - userData is a pointer that will be transparently passed through when the parallelForFunction is called.
+// Passing NULL (the default) runs all layout work on the calling thread. The resulting layout is identical either way.
+void Clay_SetParallelForFunction(void (*parallelForFunction)(void (*job)(int32_t index, void *jobData), int32_t jobCount, void *jobData, void *userData), void *userData);
 // A bounds-checked "get" function for the Clay_RenderCommandArray returned from Clay_EndLayout().
 Clay_RenderCommand * Clay_RenderCommandArray_Get(Clay_RenderCommandArray* array, int32_t index);
 // Enables and disables Clay's internal debug tools.
@@ -842,6 +963,43 @@ void Clay_SetDebugModeEnabled(bool enabled);
 bool Clay_IsDebugModeEnabled(void);
 // Enables and disables visibility culling. By default, Clay will not generate render commands for elements whose bounding box is entirely outside the screen.
 void Clay_SetCullingEnabled(bool enabled);
+// Enables and disables retained layout. When enabled, Clay hashes each element's declaration and compares it against the previous frame,
+// reusing the previous render commands for subtrees that haven't changed, and skipping layout entirely for frames where nothing has changed.
+// Its memory is only reserved once enabled: call Clay_ResizeContext() with an arena of at least Clay_MinMemorySize() afterwards.
+// This state is retained and does not need to be set each frame.
+void Clay_SetRetainedLayoutEnabled(bool enabled);
+// Enables and disables adaptive memory. When enabled, the per frame arrays are sized from the high-water mark of recent frames plus headroom,
+// rather than always from the max element count, so typical frames only touch the memory they actually need.
+// If a frame outgrows the adapted capacity, Clay_EndLayout returns an empty render command array for that frame instead of reporting an error,
+// and the next frame is given the full capacity. Check Clay_WasLayoutDropped() to skip drawing such a frame, or run the layout again.
+// This state is retained and does not need to be set each frame.
+void Clay_SetAdaptiveMemoryEnabled(bool enabled);
+// Returns true if the most recent Clay_EndLayout() dropped its frame because it outgrew the adaptive memory capacity. Its render commands are
+// empty and shouldn't be drawn, keep showing the previous frame instead. Render command diffs and packed render commands are left empty too.
+bool Clay_WasLayoutDropped(void);
+// Enables and disables render command diffing. When enabled, Clay_EndLayout() also compares its render commands against those of the previous frame,
+// so that renderers can update only what changed, or skip presenting entirely when nothing did. Takes effect from the next Clay_BeginLayout().
+// Its memory is only reserved once enabled: call Clay_ResizeContext() with an arena of at least Clay_MinMemorySize() afterwards.
+// This state is retained and does not need to be set each frame.
+void Clay_SetRenderCommandDiffEnabled(bool enabled);
+// Returns true if render command diffing is currently enabled and has memory reserved for it, so that Clay_GetRenderCommandDiff() reports changes.
+bool Clay_IsRenderCommandDiffEnabled(void);
+// Returns the render commands added, changed and removed by the most recent Clay_EndLayout(), valid until the next Clay_BeginLayout().
+// All three arrays are empty if the frame was identical to the previous one, or if render command diffing is disabled.
+// Text is compared by a hash of its contents, as with Clay_TextElementConfig.hashStringContents, so strings edited in place are reported as changed.
+// As in the text measurement cache, only the first 256 characters of each line are hashed.
+// Reordering commands without changing them isn't reported either.
+Clay_RenderCommandDiff Clay_GetRenderCommandDiff(void);
+// Enables and disables packed render commands. When enabled, Clay_EndLayout() also writes its render commands to a compact stream of
+// 32 byte records, which is cheaper for renderers to read and to copy to another thread or process. Takes effect from the next Clay_BeginLayout().
+// Its memory is only reserved once enabled: call Clay_ResizeContext() with an arena of at least Clay_MinMemorySize() afterwards.
+// This state is retained and does not need to be set each frame.
+void Clay_SetPackedRenderCommandsEnabled(bool enabled);
+// Returns true if packed render commands are currently enabled and have memory reserved for them, so that Clay_GetPackedRenderCommands() is filled.
+bool Clay_IsPackedRenderCommandsEnabled(void);
+// Returns the packed render commands of the most recent Clay_EndLayout(), valid until the next Clay_BeginLayout().
+// The stream is empty if packed render commands are disabled.
+Clay_PackedRenderCommandStream Clay_GetPackedRenderCommands(void);
 // Returns the maximum number of UI elements supported by Clay's current configuration.
 int32_t Clay_GetMaxElementCount(void);
 // Modifies the maximum number of UI elements supported by Clay's current configuration.
@@ -852,6 +1010,11 @@ int32_t Clay_GetMaxMeasureTextCacheWordCount(void);
 // Modifies the maximum number of measured "words" (whitespace seperated runs of characters) that Clay can store in its internal text measurement cache.
 // This may require reallocating additional memory, and re-calling Clay_Initialize();
 void Clay_SetMaxMeasureTextCacheWordCount(int32_t maxMeasureTextCacheWordCount);
+// Returns the maximum number of scroll containers that Clay can track scroll positions for.
+int32_t Clay_GetMaxScrollContainerCount(void);
+// Modifies the maximum number of scroll containers that Clay can track scroll positions for.
+// This may require reallocating additional memory, and re-calling Clay_Initialize();
+void Clay_SetMaxScrollContainerCount(int32_t maxScrollContainerCount);
 // Resets Clay's internal text measurement cache, useful if memory to represent strings is being re-used.
 // Similar behaviour can be achieved on an individual text element level by using Clay_TextElementConfig.hashStringContents
 void Clay_ResetMeasureTextCache(void);
@@ -920,7 +1083,7 @@ typeName arrayName##_GetValue(arrayName *array, int32_t index) {
 }                                                                                                               \
                                                                                                                 \
 typeName *arrayName##_Add(arrayName *array, typeName item) {                                                    \
-    if (Clay__Array_AddCapacityCheck(array->length, array->capacity)) {                                         \
+    if (Clay__Array_AddCapacityCheck(array->internalArray, array->length, array->capacity)) {                   \
         array->internalArray[array->length++] = item;                                                           \
         return &array->internalArray[array->length - 1];                                                        \
     }                                                                                                           \
@@ -958,9 +1121,10 @@ typedef struct                                      \
                                                     \
 CLAY__ARRAY_DEFINE_FUNCTIONS(typeName, arrayName)   \
 
-Clay_Context *Clay__currentContext;
+CLAY__THREAD_LOCAL Clay_Context *Clay__currentContext;
 int32_t Clay__defaultMaxElementCount = 8192;
 int32_t Clay__defaultMaxMeasureTextWordCacheCount = 16384;
+int32_t Clay__defaultMaxScrollContainerCount = 10;
 
 void Clay__ErrorHandlerFunctionDefault(Clay_ErrorData errorText) {
     (void) errorText;
@@ -974,6 +1138,7 @@ typedef struct {
     bool maxRenderCommandsExceeded;
     bool maxTextMeasureCacheExceeded;
     bool textMeasurementFunctionNotSet;
+    bool ephemeralCapacityExceeded;
 } Clay_BooleanWarnings;
 
 typedef struct {
@@ -1001,11 +1166,14 @@ Clay__WarningArray Clay__WarningArray_Allocate_Arena(int32_t capacity, Clay_Aren
 Clay__Warning *Clay__WarningArray_Add(Clay__WarningArray *array, Clay__Warning item);
 void* Clay__Array_Allocate_Arena(int32_t capacity, uint32_t itemSize, Clay_Arena *arena);
 bool Clay__Array_RangeCheck(int32_t index, int32_t length);
-bool Clay__Array_AddCapacityCheck(int32_t length, int32_t capacity);
+bool Clay__Array_AddCapacityCheck(const void *internalArray, int32_t length, int32_t capacity);
 
 CLAY__ARRAY_DEFINE(bool, Clay__boolArray)
 CLAY__ARRAY_DEFINE(int32_t, Clay__int32_tArray)
 CLAY__ARRAY_DEFINE(char, Clay__charArray)
+CLAY__ARRAY_DEFINE(float, Clay__floatArray)
+CLAY__ARRAY_DEFINE(uint8_t, Clay__uint8_tArray)
+CLAY__ARRAY_DEFINE(uint32_t, Clay__uint32_tArray)
 CLAY__ARRAY_DEFINE(Clay_ElementId, Clay__ElementIdArray)
 CLAY__ARRAY_DEFINE(Clay_LayoutConfig, Clay__LayoutConfigArray)
 CLAY__ARRAY_DEFINE(Clay_TextElementConfig, Clay__TextElementConfigArray)
@@ -1017,6 +1185,8 @@ CLAY__ARRAY_DEFINE(Clay_BorderElementConfig, Clay__BorderElementConfigArray)
 CLAY__ARRAY_DEFINE(Clay_String, Clay__StringArray)
 CLAY__ARRAY_DEFINE(Clay_SharedElementConfig, Clay__SharedElementConfigArray)
 CLAY__ARRAY_DEFINE_FUNCTIONS(Clay_RenderCommand, Clay_RenderCommandArray)
+CLAY__ARRAY_DEFINE(Clay_PackedRenderCommand, Clay__PackedRenderCommandArray)
+CLAY__ARRAY_DEFINE(Clay_PackedRenderCommandData, Clay__PackedRenderCommandDataArray)
 
 typedef CLAY_PACKED_ENUM {
     CLAY__ELEMENT_CONFIG_TYPE_NONE,
@@ -1027,6 +1197,7 @@ typedef CLAY_PACKED_ENUM {
     CLAY__ELEMENT_CONFIG_TYPE_TEXT,
     CLAY__ELEMENT_CONFIG_TYPE_CUSTOM,
     CLAY__ELEMENT_CONFIG_TYPE_SHARED,
+    CLAY__ELEMENT_CONFIG_TYPE_COUNT,
 } Clay__ElementConfigType;
 
 typedef union {
@@ -1053,11 +1224,40 @@ typedef struct {
 
 CLAY__ARRAY_DEFINE(Clay__WrappedTextLine, Clay__WrappedTextLineArray)
 
+typedef struct {
+    int32_t startOffset;
+    int32_t length;
+    float width;
+} Clay__MeasuredWord;
+
+CLAY__ARRAY_DEFINE(Clay__MeasuredWord, Clay__MeasuredWordArray)
+
+typedef struct {
+    Clay_Dimensions unwrappedDimensions;
+    // Each item owns a contiguous run of measuredWords, so wrapping reads them sequentially
+    int32_t measuredWordsStartIndex;
+    int32_t measuredWordsCount;
+    // The lines from the last time this text was wrapped, stored at the same indices as its words in wrappedLinesCache
+    float wrappedWidth;
+    int32_t wrappedLinesCount;
+    float spaceWidth;
+    bool containsNewlines;
+    // Hash map data
+    uint32_t id;
+    int32_t nextIndex;
+    uint32_t generation;
+} Clay__MeasureTextCacheItem;
+
+CLAY__ARRAY_DEFINE(Clay__MeasureTextCacheItem, Clay__MeasureTextCacheItemArray)
+
 typedef struct {
     Clay_String text;
     Clay_Dimensions preferredDimensions;
     int32_t elementIndex;
+    // Cache items measured this frame are never evicted during it, so the pointer stays valid until the next Clay_BeginLayout()
+    Clay__MeasureTextCacheItem *measureTextCacheItem;
     Clay__WrappedTextLineArraySlice wrappedLines;
+    bool storeWrappedLines; // Set when wrapping missed the cache, so the lines are copied into it once wrapping is done
 } Clay__TextElementData;
 
 CLAY__ARRAY_DEFINE(Clay__TextElementData, Clay__TextElementDataArray)
@@ -1076,10 +1276,26 @@ typedef struct {
     Clay_Dimensions minDimensions;
     Clay_LayoutConfig *layoutConfig;
     Clay__ElementConfigArraySlice elementConfigs;
+    uint8_t elementConfigTypes; // Bitmask with (1 << type) set for each type of config attached to this element
+    uint8_t elementConfigIndexes[CLAY__ELEMENT_CONFIG_TYPE_COUNT]; // Index into elementConfigs for each attached type
     uint32_t id;
+    uint32_t declarationHash; // Only calculated when retained layout is enabled, covers this element's configs and all of its children
+    float subtreeOverflow; // How far this element's descendants can draw outside of its bounding box
+    bool floatingAttachTargetInSubtree; // A floating element attaches to this element or one of its descendants, so the subtree must always be positioned
 } Clay_LayoutElement;
 
 CLAY__ARRAY_DEFINE(Clay_LayoutElement, Clay_LayoutElementArray)
+CLAY__ARRAY_DEFINE(Clay_SizingAxis, Clay__SizingAxisArray)
+
+// Summarises the element configs that affect sizing, so the sizing passes don't need to scan them
+enum {
+    CLAY__SIZING_FLAG_TEXT = 1,
+    CLAY__SIZING_FLAG_TEXT_WRAP_WORDS = 2,
+    CLAY__SIZING_FLAG_IMAGE = 4,
+    CLAY__SIZING_FLAG_SCROLL_HORIZONTAL = 8,
+    CLAY__SIZING_FLAG_SCROLL_VERTICAL = 16,
+    CLAY__SIZING_FLAG_HAS_CHILDREN = 32,
+};
 
 typedef struct {
     Clay_LayoutElement *layoutElement;
@@ -1105,45 +1321,51 @@ typedef struct {
 
 CLAY__ARRAY_DEFINE(Clay__DebugElementData, Clay__DebugElementDataArray)
 
-typedef struct { // todo get this struct into a single cache line
+// Data retained from the previous frame, used to skip generating render commands for unchanged subtrees
+typedef struct {
+    uint32_t declarationHash;
+    uint32_t renderCommandsVersion;
+    int32_t renderCommandsStart;
+    int32_t renderCommandsLength;
+    int16_t zIndex;
+    Clay_BoundingBox cullBoundingBox;
+} Clay__RetainedElementData;
+
+typedef struct {
     Clay_BoundingBox boundingBox;
+    Clay_BoundingBox subtreeBoundingBox; // Covers this element and all of its non floating descendants, used to prune pointer hit testing
+    uint32_t subtreeBoundingBoxGeneration;
+    int32_t scrollContainerDataIndex; // Index into scrollContainerDatas, only valid if the data at that index has a matching elementId
     Clay_ElementId elementId;
     Clay_LayoutElement* layoutElement;
     void (*onHoverFunction)(Clay_ElementId elementId, Clay_PointerData pointerInfo, intptr_t userData);
     intptr_t hoverFunctionUserData;
-    int32_t nextIndex;
     uint32_t generation;
     uint32_t idAlias;
     Clay__DebugElementData *debugData;
+    Clay__RetainedElementData retained;
+    bool childrenCulled; // The final layout skipped this element's offscreen descendants, so their bounding boxes are out of date
 } Clay_LayoutElementHashMapItem;
 
 CLAY__ARRAY_DEFINE(Clay_LayoutElementHashMapItem, Clay__LayoutElementHashMapItemArray)
 
+// A slot in the open addressing element hash map. Only the id and the index of the out of line Clay_LayoutElementHashMapItem are stored,
+// so a probe sequence touches 8 bytes per slot rather than a whole hash map item.
 typedef struct {
-    int32_t startOffset;
-    int32_t length;
-    float width;
-    int32_t next;
-} Clay__MeasuredWord;
-
-CLAY__ARRAY_DEFINE(Clay__MeasuredWord, Clay__MeasuredWordArray)
-
-typedef struct {
-    Clay_Dimensions unwrappedDimensions;
-    int32_t measuredWordsStartIndex;
-    bool containsNewlines;
-    // Hash map data
     uint32_t id;
-    int32_t nextIndex;
-    uint32_t generation;
-} Clay__MeasureTextCacheItem;
+    int32_t itemIndex; // -1 if the slot is empty
+} Clay__LayoutElementHashMapSlot;
 
-CLAY__ARRAY_DEFINE(Clay__MeasureTextCacheItem, Clay__MeasureTextCacheItemArray)
+CLAY__ARRAY_DEFINE(Clay__LayoutElementHashMapSlot, Clay__LayoutElementHashMapSlotArray)
 
 typedef struct {
     Clay_LayoutElement *layoutElement;
     Clay_Vector2 position;
     Clay_Vector2 nextChildOffset;
+    Clay_LayoutElementHashMapItem *hashMapItem;
+    Clay_BoundingBox subtreeBoundingBox;
+    Clay_BoundingBox cullBoundingBox; // The visible part of the window, after all enclosing scroll containers' scissors
+    int32_t parentNodeIndex;
 } Clay__LayoutElementTreeNode;
 
 CLAY__ARRAY_DEFINE(Clay__LayoutElementTreeNode, Clay__LayoutElementTreeNodeArray)
@@ -1161,6 +1383,7 @@ CLAY__ARRAY_DEFINE(Clay__LayoutElementTreeRoot, Clay__LayoutElementTreeRootArray
 struct Clay_Context {
     int32_t maxElementCount;
     int32_t maxMeasureTextCacheWordCount;
+    int32_t maxScrollContainerCount;
     bool warningsEnabled;
     Clay_ErrorHandler errorHandler;
     Clay_BooleanWarnings booleanWarnings;
@@ -1173,11 +1396,21 @@ struct Clay_Context {
     bool debugModeEnabled;
     bool disableCulling;
     bool externalScrollHandlingEnabled;
+    bool retainedLayoutEnabled;
+    // Set once the missing retained layout memory has been reported, so that the error isn't repeated every frame
+    bool retainedLayoutMemoryErrorReported;
     uint32_t debugSelectedElementId;
     uint32_t generation;
+    uint32_t layoutVersion; // Incremented every time final element positions are calculated
+    uint32_t pointerOverLayoutVersion;
+    Clay_Vector2 pointerOverPosition;
     uintptr_t arenaResetOffset;
+    Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
+    Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData);
     void *measureTextUserData;
     void *queryScrollOffsetUserData;
+    void (*parallelForFunction)(void (*job)(int32_t index, void *jobData), int32_t jobCount, void *jobData, void *userData);
+    void *parallelForUserData;
     Clay_Arena internalArena;
     // Layout Elements / Render Commands
     Clay_LayoutElementArray layoutElements;
@@ -1189,6 +1422,12 @@ struct Clay_Context {
     Clay__int32_tArray imageElementPointers;
     Clay__int32_tArray reusableElementIndexBuffer;
     Clay__int32_tArray layoutElementClipElementIds;
+    // Sizing data for the axis currently being sized, indexed by layout element index
+    Clay__floatArray layoutElementSizes;
+    Clay__floatArray layoutElementMinSizes;
+    Clay__SizingAxisArray layoutElementSizings;
+    Clay__uint8_tArray layoutElementSizingFlags;
+    Clay__floatArray sizeDistributionBuffer; // Scratch space for sorting child sizes while distributing space between siblings
     // Configs
     Clay__LayoutConfigArray layoutConfigs;
     Clay__ElementConfigArray elementConfigs;
@@ -1205,18 +1444,50 @@ struct Clay_Context {
     Clay__LayoutElementTreeNodeArray layoutElementTreeNodeArray1;
     Clay__LayoutElementTreeRootArray layoutElementTreeRoots;
     Clay__LayoutElementHashMapItemArray layoutElementsHashMapInternal;
-    Clay__int32_tArray layoutElementsHashMap;
+    Clay__LayoutElementHashMapSlotArray layoutElementsHashMap; // Capacity is always a power of two
     Clay__MeasureTextCacheItemArray measureTextHashMapInternal;
     Clay__int32_tArray measureTextHashMapInternalFreeList;
     Clay__int32_tArray measureTextHashMap;
     Clay__MeasuredWordArray measuredWords;
-    Clay__int32_tArray measuredWordsFreeList;
+    // Indexed like measuredWords. At the start of each run of words, the index of the cache item that owns it, or -(run length) - 1 once freed
+    Clay__int32_tArray measuredWordRunOwners;
+    // Indexed like measuredWords, each line's offset, length and width. A text never wraps to more lines than it has words
+    Clay__MeasuredWordArray wrappedLinesCache;
     Clay__int32_tArray openClipElementStack;
     Clay__ElementIdArray pointerOverIds;
     Clay__ScrollContainerDataInternalArray scrollContainerDatas;
     Clay__boolArray treeNodeVisited;
     Clay__charArray dynamicStringData;
     Clay__DebugElementDataArray debugElementData;
+    // Retained Layout
+    Clay_RenderCommandArray retainedRenderCommands;
+    uint32_t retainedRenderCommandsVersion;
+    uint32_t retainedFrameHash;
+    Clay_Dimensions retainedLayoutDimensions;
+    bool retainedDisableCulling;
+    // Adaptive memory
+    bool adaptiveMemoryEnabled;
+    int32_t ephemeralElementCapacity; // Capacity the per element ephemeral arrays were allocated with this frame
+    // Arena offsets of the arrays allocated with ephemeralElementCapacity, the only ones whose overflow drops the frame rather than reporting an error
+    uintptr_t adaptiveArraysStart;
+    uintptr_t adaptiveArraysEnd;
+    int32_t ephemeralHighWaterMark;
+    // Render command diffing
+    bool renderCommandDiffEnabled;
+    bool renderCommandDiffMemoryErrorReported;
+    Clay_RenderCommandArray previousRenderCommands;
+    Clay__uint32_tArray previousRenderCommandTextHashes; // Hashes of the previous frame's text, whose memory may since have been edited in place
+    Clay_RenderCommandArray renderCommandDiffBuffer;
+    Clay__uint32_tArray renderCommandDiffTextHashes;
+    Clay__int32_tArray renderCommandDiffTable;
+    Clay__int32_tArray renderCommandDiffMatches;
+    Clay__boolArray renderCommandDiffMatched;
+    Clay_RenderCommandDiff renderCommandDiff;
+    // Packed render commands
+    bool packedRenderCommandsEnabled;
+    bool packedRenderCommandsMemoryErrorReported;
+    Clay__PackedRenderCommandArray packedRenderCommands;
+    Clay__PackedRenderCommandDataArray packedRenderCommandData;
 };
 
 Clay_Context* Clay__Context_Allocate_Arena(Clay_Arena *arena) {
@@ -1232,6 +1503,21 @@ Clay_Context* Clay__Context_Allocate_Arena(Clay_Arena *arena) {
     return (Clay_Context*)(memoryAddress + nextAllocOffset);
 }
 
+// Retained layout needs memory that is only reserved when the context is initialized or resized with it enabled
+bool Clay__RetainedLayoutActive(Clay_Context* context) {
+    return context->retainedLayoutEnabled && context->retainedRenderCommands.capacity > 0;
+}
+
+// As with retained layout, render command diffing only has memory once the context is initialized or resized with it enabled
+bool Clay__RenderCommandDiffActive(Clay_Context* context) {
+    return context->renderCommandDiffEnabled && context->previousRenderCommands.capacity > 0;
+}
+
+// Likewise for packed render commands
+bool Clay__PackedRenderCommandsActive(Clay_Context* context) {
+    return context->packedRenderCommandsEnabled && context->packedRenderCommands.capacity > 0;
+}
+
 Clay_String Clay__WriteStringToCharBuffer(Clay__charArray *buffer, Clay_String string) {
     for (int32_t i = 0; i < string.length; i++) {
         buffer->internalArray[buffer->length + i] = string.chars[i];
@@ -1244,8 +1530,13 @@ Clay_String Clay__WriteStringToCharBuffer(Clay__charArray *buffer, Clay_String s
     __attribute__((import_module("clay"), import_name("measureTextFunction"))) Clay_Dimensions Clay__MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
     __attribute__((import_module("clay"), import_name("queryScrollOffsetFunction"))) Clay_Vector2 Clay__QueryScrollOffset(uint32_t elementId, void *userData);
 #else
-    Clay_Dimensions (*Clay__MeasureText)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
-    Clay_Vector2 (*Clay__QueryScrollOffset)(uint32_t elementId, void *userData);
+Clay_Dimensions Clay__MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    return Clay_GetCurrentContext()->measureTextFunction(text, config, userData);
+}
+
+Clay_Vector2 Clay__QueryScrollOffset(uint32_t elementId, void *userData) {
+    return Clay_GetCurrentContext()->queryScrollOffsetFunction(elementId, userData);
+}
 #endif
 
 Clay_LayoutElement* Clay__GetOpenLayoutElement(void) {
@@ -1273,18 +1564,24 @@ Clay_ElementConfig Clay__AttachElementConfig(Clay_ElementConfigUnion config, Cla
         return CLAY__INIT(Clay_ElementConfig) CLAY__DEFAULT_STRUCT;
     }
     Clay_LayoutElement *openLayoutElement = Clay__GetOpenLayoutElement();
+    Clay_ElementConfig *elementConfig = Clay__ElementConfigArray_Add(&context->elementConfigs, CLAY__INIT(Clay_ElementConfig) { .type = type, .config = config });
+    if (elementConfig != &Clay_ElementConfig_DEFAULT && !(openLayoutElement->elementConfigTypes & (1 << type))) {
+        openLayoutElement->elementConfigTypes |= (uint8_t)(1 << type);
+        openLayoutElement->elementConfigIndexes[type] = (uint8_t)openLayoutElement->elementConfigs.length;
+    }
     openLayoutElement->elementConfigs.length++;
-    return *Clay__ElementConfigArray_Add(&context->elementConfigs, CLAY__INIT(Clay_ElementConfig) { .type = type, .config = config });
+    return *elementConfig;
+}
+
+bool Clay__ElementHasConfig(Clay_LayoutElement *layoutElement, Clay__ElementConfigType type) {
+    return (layoutElement->elementConfigTypes & (1 << type)) != 0;
 }
 
 Clay_ElementConfigUnion Clay__FindElementConfigWithType(Clay_LayoutElement *element, Clay__ElementConfigType type) {
-    for (int32_t i = 0; i < element->elementConfigs.length; i++) {
-        Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&element->elementConfigs, i);
-        if (config->type == type) {
-            return config->config;
-        }
+    if (!Clay__ElementHasConfig(element, type)) {
+        return CLAY__INIT(Clay_ElementConfigUnion) { NULL };
     }
-    return CLAY__INIT(Clay_ElementConfigUnion) { NULL };
+    return element->elementConfigs.internalArray[element->elementConfigIndexes[type]].config;
 }
 
 Clay_ElementId Clay__HashNumber(const uint32_t offset, const uint32_t seed) {
@@ -1369,24 +1666,184 @@ uint32_t Clay__HashTextWithConfig(Clay_String *text, Clay_TextElementConfig *con
     return hash + 1; // Reserve the hash result of zero as "null id"
 }
 
-Clay__MeasuredWord *Clay__AddMeasuredWord(Clay__MeasuredWord word, Clay__MeasuredWord *previousWord) {
+uint32_t Clay__HashMix(uint32_t hash, uint32_t value) {
+    hash += value;
+    hash += (hash << 10);
+    hash ^= (hash >> 6);
+    return hash;
+}
+
+uint32_t Clay__HashMixFloat(uint32_t hash, float value) {
+    union { float asFloat; uint32_t asBits; } bits = { value };
+    return Clay__HashMix(hash, bits.asBits);
+}
+
+uint32_t Clay__HashMixPointer(uint32_t hash, void *pointer) {
+    uint64_t pointerAsNumber = (uint64_t)(uintptr_t)pointer;
+    hash = Clay__HashMix(hash, (uint32_t)pointerAsNumber);
+    return Clay__HashMix(hash, (uint32_t)(pointerAsNumber >> 32));
+}
+
+uint32_t Clay__HashMixColor(uint32_t hash, Clay_Color color) {
+    hash = Clay__HashMixFloat(hash, color.r);
+    hash = Clay__HashMixFloat(hash, color.g);
+    hash = Clay__HashMixFloat(hash, color.b);
+    return Clay__HashMixFloat(hash, color.a);
+}
+
+uint32_t Clay__HashMixSizingAxis(uint32_t hash, Clay_SizingAxis axis) {
+    hash = Clay__HashMix(hash, axis.type);
+    hash = Clay__HashMixFloat(hash, axis.size.minMax.min); // Aliases percent
+    return Clay__HashMixFloat(hash, axis.type == CLAY__SIZING_TYPE_PERCENT ? 0 : axis.size.minMax.max);
+}
+
+// Hashes everything about an element's own declaration that can affect its layout or render commands. Children are mixed in when the element is closed.
+uint32_t Clay__HashElementDeclaration(Clay_LayoutElement *layoutElement, Clay_Vector2 scrollPosition) {
+    uint32_t hash = layoutElement->id;
+    Clay_LayoutConfig *layoutConfig = layoutElement->layoutConfig;
+    hash = Clay__HashMixSizingAxis(hash, layoutConfig->sizing.width);
+    hash = Clay__HashMixSizingAxis(hash, layoutConfig->sizing.height);
+    hash = Clay__HashMix(hash, layoutConfig->padding.left | (layoutConfig->padding.right << 16));
+    hash = Clay__HashMix(hash, layoutConfig->padding.top | (layoutConfig->padding.bottom << 16));
+    hash = Clay__HashMix(hash, layoutConfig->childGap | (layoutConfig->childAlignment.x << 16) | (layoutConfig->childAlignment.y << 20) | (layoutConfig->layoutDirection << 24));
+    for (int32_t i = 0; i < layoutElement->elementConfigs.length; i++) {
+        Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&layoutElement->elementConfigs, i);
+        hash = Clay__HashMix(hash, config->type);
+        switch (config->type) {
+            case CLAY__ELEMENT_CONFIG_TYPE_SHARED: {
+                Clay_SharedElementConfig *sharedConfig = config->config.sharedElementConfig;
+                hash = Clay__HashMixColor(hash, sharedConfig->backgroundColor);
+                hash = Clay__HashMixFloat(hash, sharedConfig->cornerRadius.topLeft);
+                hash = Clay__HashMixFloat(hash, sharedConfig->cornerRadius.topRight);
+                hash = Clay__HashMixFloat(hash, sharedConfig->cornerRadius.bottomLeft);
+                hash = Clay__HashMixFloat(hash, sharedConfig->cornerRadius.bottomRight);
+                hash = Clay__HashMixPointer(hash, sharedConfig->userData);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_IMAGE: {
+                Clay_ImageElementConfig *imageConfig = config->config.imageElementConfig;
+                hash = Clay__HashMixPointer(hash, imageConfig->imageData);
+                hash = Clay__HashMixFloat(hash, imageConfig->sourceDimensions.width);
+                hash = Clay__HashMixFloat(hash, imageConfig->sourceDimensions.height);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_FLOATING: {
+                Clay_FloatingElementConfig *floatingConfig = config->config.floatingElementConfig;
+                hash = Clay__HashMixFloat(hash, floatingConfig->offset.x);
+                hash = Clay__HashMixFloat(hash, floatingConfig->offset.y);
+                hash = Clay__HashMixFloat(hash, floatingConfig->expand.width);
+                hash = Clay__HashMixFloat(hash, floatingConfig->expand.height);
+                hash = Clay__HashMix(hash, floatingConfig->parentId);
+                hash = Clay__HashMix(hash, (uint16_t)floatingConfig->zIndex | (floatingConfig->attachPoints.element << 16) | (floatingConfig->attachPoints.parent << 24));
+                hash = Clay__HashMix(hash, floatingConfig->pointerCaptureMode | (floatingConfig->attachTo << 8));
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_CUSTOM: {
+                hash = Clay__HashMixPointer(hash, config->config.customElementConfig->customData);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_SCROLL: {
+                Clay_ScrollElementConfig *scrollConfig = config->config.scrollElementConfig;
+                hash = Clay__HashMix(hash, scrollConfig->horizontal | (scrollConfig->vertical << 8));
+                hash = Clay__HashMixFloat(hash, scrollPosition.x);
+                hash = Clay__HashMixFloat(hash, scrollPosition.y);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_BORDER: {
+                Clay_BorderElementConfig *borderConfig = config->config.borderElementConfig;
+                hash = Clay__HashMixColor(hash, borderConfig->color);
+                hash = Clay__HashMix(hash, borderConfig->width.left | (borderConfig->width.right << 16));
+                hash = Clay__HashMix(hash, borderConfig->width.top | (borderConfig->width.bottom << 16));
+                hash = Clay__HashMix(hash, borderConfig->width.betweenChildren);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_TEXT: {
+                Clay_TextElementConfig *textConfig = config->config.textElementConfig;
+                Clay_String text = layoutElement->childrenOrTextContent.textElementData->text;
+                // Render commands reference the string directly, so the pointer is always part of the hash
+                // The measure text cache item's id is already this hash, unless the text couldn't be measured
+                uint32_t measureTextCacheId = layoutElement->childrenOrTextContent.textElementData->measureTextCacheItem->id;
+                hash = Clay__HashMix(hash, measureTextCacheId != 0 ? measureTextCacheId : Clay__HashTextWithConfig(&text, textConfig));
+                hash = Clay__HashMixPointer(hash, (void *)text.chars);
+                hash = Clay__HashMixColor(hash, textConfig->textColor);
+                hash = Clay__HashMix(hash, textConfig->textAlignment);
+                break;
+            }
+            default: break;
+        }
+    }
+    return hash;
+}
+
+uint32_t Clay__HashFinalize(uint32_t hash) {
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return hash;
+}
+
+// Marks a cache item's run of measured words as free. The space is reclaimed the next time the words are compacted
+void Clay__FreeMeasuredWords(Clay__MeasureTextCacheItem *cacheItem) {
     Clay_Context* context = Clay_GetCurrentContext();
-    if (context->measuredWordsFreeList.length > 0) {
-        uint32_t newItemIndex = Clay__int32_tArray_GetValue(&context->measuredWordsFreeList, (int)context->measuredWordsFreeList.length - 1);
-        context->measuredWordsFreeList.length--;
-        Clay__MeasuredWordArray_Set(&context->measuredWords, (int)newItemIndex, word);
-        previousWord->next = (int32_t)newItemIndex;
-        return Clay__MeasuredWordArray_Get(&context->measuredWords, (int)newItemIndex);
-    } else {
-        previousWord->next = (int32_t)context->measuredWords.length;
-        return Clay__MeasuredWordArray_Add(&context->measuredWords, word);
+    if (cacheItem->measuredWordsCount > 0) {
+        context->measuredWordRunOwners.internalArray[cacheItem->measuredWordsStartIndex] = -cacheItem->measuredWordsCount - 1;
+    }
+}
+
+// Slides every live run of measured words down over the freed ones, keeping them in order. The words from pendingStart onwards belong to
+// a measurement that is still in progress, and move along with the rest. Returns the new start of the pending words.
+int32_t Clay__CompactMeasuredWords(int32_t pendingStart) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__MeasuredWord *words = context->measuredWords.internalArray;
+    Clay__MeasuredWord *wrappedLines = context->wrappedLinesCache.internalArray;
+    int32_t *runOwners = context->measuredWordRunOwners.internalArray;
+    int32_t writeIndex = 0;
+    int32_t readIndex = 0;
+    while (readIndex < pendingStart) {
+        int32_t owner = runOwners[readIndex];
+        if (owner < 0) {
+            readIndex += -owner - 1;
+            continue;
+        }
+        Clay__MeasureTextCacheItem *cacheItem = &context->measureTextHashMapInternal.internalArray[owner];
+        if (writeIndex != readIndex) {
+            for (int32_t i = 0; i < cacheItem->measuredWordsCount; ++i) {
+                words[writeIndex + i] = words[readIndex + i];
+            }
+            for (int32_t i = 0; i < cacheItem->wrappedLinesCount; ++i) {
+                wrappedLines[writeIndex + i] = wrappedLines[readIndex + i];
+            }
+            cacheItem->measuredWordsStartIndex = writeIndex;
+            runOwners[writeIndex] = owner;
+        }
+        writeIndex += cacheItem->measuredWordsCount;
+        readIndex += cacheItem->measuredWordsCount;
+    }
+    int32_t pendingCount = context->measuredWords.length - pendingStart;
+    for (int32_t i = 0; i < pendingCount; ++i) {
+        words[writeIndex + i] = words[pendingStart + i];
+    }
+    context->measuredWords.length = writeIndex + pendingCount;
+    return writeIndex;
+}
+
+// Appends a word to the run being measured, compacting the measured words first if they are full. Returns false if there's still no room.
+bool Clay__AddMeasuredWord(Clay__MeasuredWord word, int32_t *runStart) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (context->measuredWords.length == context->measuredWords.capacity) {
+        *runStart = Clay__CompactMeasuredWords(*runStart);
+        if (context->measuredWords.length == context->measuredWords.capacity) {
+            return false;
+        }
     }
+    context->measuredWords.internalArray[context->measuredWords.length++] = word;
+    return true;
 }
 
 Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_TextElementConfig *config) {
     Clay_Context* context = Clay_GetCurrentContext();
     #ifndef CLAY_WASM
-    if (!Clay__MeasureText) {
+    if (!context->measureTextFunction) {
         if (!context->booleanWarnings.textMeasurementFunctionNotSet) {
             context->booleanWarnings.textMeasurementFunctionNotSet = true;
             context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
@@ -1409,13 +1866,7 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
         }
         // This element hasn't been seen in a few frames, delete the hash map item
         if (context->generation - hashEntry->generation > 2) {
-            // Add all the measured words that were included in this measurement to the freelist
-            int32_t nextWordIndex = hashEntry->measuredWordsStartIndex;
-            while (nextWordIndex != -1) {
-                Clay__MeasuredWord *measuredWord = Clay__MeasuredWordArray_Get(&context->measuredWords, nextWordIndex);
-                Clay__int32_tArray_Add(&context->measuredWordsFreeList, nextWordIndex);
-                nextWordIndex = measuredWord->next;
-            }
+            Clay__FreeMeasuredWords(hashEntry);
 
             int32_t nextIndex = hashEntry->nextIndex;
             Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, elementIndex, CLAY__INIT(Clay__MeasureTextCacheItem) { .measuredWordsStartIndex = -1 });
@@ -1462,19 +1913,9 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
     float measuredWidth = 0;
     float measuredHeight = 0;
     float spaceWidth = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars }, config, context->measureTextUserData).width;
-    Clay__MeasuredWord tempWord = { .next = -1 };
-    Clay__MeasuredWord *previousWord = &tempWord;
-    while (end < text->length) {
-        if (context->measuredWords.length == context->measuredWords.capacity - 1) {
-            if (!context->booleanWarnings.maxTextMeasureCacheExceeded) {
-                context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                    .errorType = CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED,
-                    .errorText = CLAY_STRING("Clay has run out of space in it's internal text measurement cache. Try using Clay_SetMaxMeasureTextCacheWordCount() (default 16384, with 1 unit storing 1 measured word)."),
-                    .userData = context->errorHandler.userData });
-                context->booleanWarnings.maxTextMeasureCacheExceeded = true;
-            }
-            return &Clay__MeasureTextCacheItem_DEFAULT;
-        }
+    int32_t runStart = context->measuredWords.length;
+    bool wordsFit = true;
+    while (end < text->length && wordsFit) {
         char current = text->chars[end];
         if (current == ' ' || current == '\n') {
             int32_t length = end - start;
@@ -1482,14 +1923,14 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
             measuredHeight = CLAY__MAX(measuredHeight, dimensions.height);
             if (current == ' ') {
                 dimensions.width += spaceWidth;
-                previousWord = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = length + 1, .width = dimensions.width, .next = -1 }, previousWord);
+                wordsFit = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = length + 1, .width = dimensions.width }, &runStart);
                 lineWidth += dimensions.width;
             }
             if (current == '\n') {
                 if (length > 0) {
-                    previousWord = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = length, .width = dimensions.width, .next = -1 }, previousWord);
+                    wordsFit = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = length, .width = dimensions.width }, &runStart);
                 }
-                previousWord = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = end + 1, .length = 0, .width = 0, .next = -1 }, previousWord);
+                wordsFit = wordsFit && Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = end + 1, .length = 0, .width = 0 }, &runStart);
                 lineWidth += dimensions.width;
                 measuredWidth = CLAY__MAX(lineWidth, measuredWidth);
                 measured->containsNewlines = true;
@@ -1499,15 +1940,34 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
         }
         end++;
     }
-    if (end - start > 0) {
+    if (wordsFit && end - start > 0) {
         Clay_Dimensions dimensions = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = end - start, .chars = &text->chars[start], .baseChars = text->chars }, config, context->measureTextUserData);
-        Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = end - start, .width = dimensions.width, .next = -1 }, previousWord);
+        wordsFit = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = end - start, .width = dimensions.width }, &runStart);
         lineWidth += dimensions.width;
         measuredHeight = CLAY__MAX(measuredHeight, dimensions.height);
     }
+    if (!wordsFit) {
+        // Give back the partial run and the unlinked cache item
+        context->measuredWords.length = runStart;
+        Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, newItemIndex, CLAY__INIT(Clay__MeasureTextCacheItem) { .measuredWordsStartIndex = -1 });
+        Clay__int32_tArray_Add(&context->measureTextHashMapInternalFreeList, newItemIndex);
+        if (!context->booleanWarnings.maxTextMeasureCacheExceeded) {
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                .errorType = CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED,
+                .errorText = CLAY_STRING("Clay has run out of space in it's internal text measurement cache. Try using Clay_SetMaxMeasureTextCacheWordCount() (default 16384, with 1 unit storing 1 measured word)."),
+                .userData = context->errorHandler.userData });
+            context->booleanWarnings.maxTextMeasureCacheExceeded = true;
+        }
+        return &Clay__MeasureTextCacheItem_DEFAULT;
+    }
     measuredWidth = CLAY__MAX(lineWidth, measuredWidth);
 
-    measured->measuredWordsStartIndex = tempWord.next;
+    measured->measuredWordsStartIndex = runStart;
+    measured->measuredWordsCount = context->measuredWords.length - runStart;
+    if (measured->measuredWordsCount > 0) {
+        context->measuredWordRunOwners.internalArray[runStart] = newItemIndex;
+    }
+    measured->spaceWidth = spaceWidth;
     measured->unwrappedDimensions.width = measuredWidth;
     measured->unwrappedDimensions.height = measuredHeight;
 
@@ -1523,60 +1983,136 @@ bool Clay__PointIsInsideRect(Clay_Vector2 point, Clay_BoundingBox rect) {
     return point.x >= rect.x && point.x <= rect.x + rect.width && point.y >= rect.y && point.y <= rect.y + rect.height;
 }
 
+// Used to prune hit testing, so errs on the side of including points that are within floating point error of the rect
+bool Clay__PointMayBeInsideRect(Clay_Vector2 point, Clay_BoundingBox rect) {
+    return point.x >= rect.x - 1 && point.x <= rect.x + rect.width + 1 && point.y >= rect.y - 1 && point.y <= rect.y + rect.height + 1;
+}
+
+Clay_BoundingBox Clay__UnionBoundingBoxes(Clay_BoundingBox a, Clay_BoundingBox b) {
+    float minX = CLAY__MIN(a.x, b.x);
+    float minY = CLAY__MIN(a.y, b.y);
+    float maxX = CLAY__MAX(a.x + a.width, b.x + b.width);
+    float maxY = CLAY__MAX(a.y + a.height, b.y + b.height);
+    return CLAY__INIT(Clay_BoundingBox) { minX, minY, maxX - minX, maxY - minY };
+}
+
+// Boxes that don't overlap produce a negative width or height, boxes that only touch produce a zero width or height
+Clay_BoundingBox Clay__IntersectBoundingBoxes(Clay_BoundingBox a, Clay_BoundingBox b) {
+    float minX = CLAY__MAX(a.x, b.x);
+    float minY = CLAY__MAX(a.y, b.y);
+    float maxX = CLAY__MIN(a.x + a.width, b.x + b.width);
+    float maxY = CLAY__MIN(a.y + a.height, b.y + b.height);
+    return CLAY__INIT(Clay_BoundingBox) { minX, minY, maxX - minX, maxY - minY };
+}
+
+// Element ids are already hashes, but ids generated from sequential offsets differ mostly in their low bits - mix before masking
+uint32_t Clay__LayoutElementHashMapHomeSlot(uint32_t id, uint32_t mask) {
+    id ^= id >> 16;
+    id *= 0x45d9f3b;
+    id ^= id >> 16;
+    return id & mask;
+}
+
+// Robin hood linear probing. Every slot's distance from its home slot is recomputed from its id, and a lookup can stop as soon as it reaches
+// a slot that is closer to home than the probe is, because an insert would have displaced that slot's entry.
+int32_t Clay__FindLayoutElementHashMapSlot(uint32_t id) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    uint32_t mask = (uint32_t)context->layoutElementsHashMap.capacity - 1;
+    uint32_t slotIndex = Clay__LayoutElementHashMapHomeSlot(id, mask);
+    for (uint32_t distance = 0; distance <= mask; ++distance) {
+        Clay__LayoutElementHashMapSlot *slot = &context->layoutElementsHashMap.internalArray[slotIndex];
+        if (slot->itemIndex == -1 || ((slotIndex - Clay__LayoutElementHashMapHomeSlot(slot->id, mask)) & mask) < distance) {
+            return -1;
+        }
+        if (slot->id == id) {
+            return slot->itemIndex;
+        }
+        slotIndex = (slotIndex + 1) & mask;
+    }
+    return -1;
+}
+
+void Clay__InsertLayoutElementHashMapSlot(Clay__LayoutElementHashMapSlot toInsert) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    uint32_t mask = (uint32_t)context->layoutElementsHashMap.capacity - 1;
+    uint32_t slotIndex = Clay__LayoutElementHashMapHomeSlot(toInsert.id, mask);
+    uint32_t distance = 0;
+    while (true) {
+        Clay__LayoutElementHashMapSlot *slot = &context->layoutElementsHashMap.internalArray[slotIndex];
+        if (slot->itemIndex == -1) {
+            *slot = toInsert;
+            return;
+        }
+        uint32_t slotDistance = (slotIndex - Clay__LayoutElementHashMapHomeSlot(slot->id, mask)) & mask;
+        if (slotDistance < distance) {
+            Clay__LayoutElementHashMapSlot displaced = *slot;
+            *slot = toInsert;
+            toInsert = displaced;
+            distance = slotDistance;
+        }
+        slotIndex = (slotIndex + 1) & mask;
+        distance++;
+    }
+}
+
 Clay_LayoutElementHashMapItem* Clay__AddHashMapItem(Clay_ElementId elementId, Clay_LayoutElement* layoutElement, uint32_t idAlias) {
     Clay_Context* context = Clay_GetCurrentContext();
     if (context->layoutElementsHashMapInternal.length == context->layoutElementsHashMapInternal.capacity - 1) {
         return NULL;
     }
-    Clay_LayoutElementHashMapItem item = { .elementId = elementId, .layoutElement = layoutElement, .nextIndex = -1, .generation = context->generation + 1, .idAlias = idAlias };
-    uint32_t hashBucket = elementId.id % context->layoutElementsHashMap.capacity;
-    int32_t hashItemPrevious = -1;
-    int32_t hashItemIndex = context->layoutElementsHashMap.internalArray[hashBucket];
-    while (hashItemIndex != -1) { // Just replace collision, not a big deal - leave it up to the end user
+    Clay_LayoutElementHashMapItem item = { .elementId = elementId, .layoutElement = layoutElement, .generation = context->generation + 1, .idAlias = idAlias };
+    int32_t hashItemIndex = Clay__FindLayoutElementHashMapSlot(elementId.id);
+    if (hashItemIndex != -1) { // Collision - resolve based on generation. Just replace collision, not a big deal - leave it up to the end user
         Clay_LayoutElementHashMapItem *hashItem = Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, hashItemIndex);
-        if (hashItem->elementId.id == elementId.id) { // Collision - resolve based on generation
-            item.nextIndex = hashItem->nextIndex;
-            if (hashItem->generation <= context->generation) { // First collision - assume this is the "same" element
-                hashItem->elementId = elementId; // Make sure to copy this across. If the stringId reference has changed, we should update the hash item to use the new one.
-                hashItem->generation = context->generation + 1;
-                hashItem->layoutElement = layoutElement;
-                hashItem->debugData->collision = false;
-            } else { // Multiple collisions this frame - two elements have the same ID
-                context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                    .errorType = CLAY_ERROR_TYPE_DUPLICATE_ID,
-                    .errorText = CLAY_STRING("An element with this ID was already previously declared during this layout."),
-                    .userData = context->errorHandler.userData });
-                if (context->debugModeEnabled) {
-                    hashItem->debugData->collision = true;
-                }
+        if (hashItem->generation <= context->generation) { // First collision - assume this is the "same" element
+            hashItem->elementId = elementId; // Make sure to copy this across. If the stringId reference has changed, we should update the hash item to use the new one.
+            hashItem->generation = context->generation + 1;
+            hashItem->layoutElement = layoutElement;
+            hashItem->debugData->collision = false;
+        } else { // Multiple collisions this frame - two elements have the same ID
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                .errorType = CLAY_ERROR_TYPE_DUPLICATE_ID,
+                .errorText = CLAY_STRING("An element with this ID was already previously declared during this layout."),
+                .userData = context->errorHandler.userData });
+            if (context->debugModeEnabled) {
+                hashItem->debugData->collision = true;
             }
-            return hashItem;
         }
-        hashItemPrevious = hashItemIndex;
-        hashItemIndex = hashItem->nextIndex;
+        return hashItem;
     }
     Clay_LayoutElementHashMapItem *hashItem = Clay__LayoutElementHashMapItemArray_Add(&context->layoutElementsHashMapInternal, item);
     hashItem->debugData = Clay__DebugElementDataArray_Add(&context->debugElementData, CLAY__INIT(Clay__DebugElementData) CLAY__DEFAULT_STRUCT);
-    if (hashItemPrevious != -1) {
-        Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, hashItemPrevious)->nextIndex = (int32_t)context->layoutElementsHashMapInternal.length - 1;
-    } else {
-        context->layoutElementsHashMap.internalArray[hashBucket] = (int32_t)context->layoutElementsHashMapInternal.length - 1;
-    }
+    Clay__InsertLayoutElementHashMapSlot(CLAY__INIT(Clay__LayoutElementHashMapSlot) { .id = elementId.id, .itemIndex = (int32_t)context->layoutElementsHashMapInternal.length - 1 });
     return hashItem;
 }
 
 Clay_LayoutElementHashMapItem *Clay__GetHashMapItem(uint32_t id) {
     Clay_Context* context = Clay_GetCurrentContext();
-    uint32_t hashBucket = id % context->layoutElementsHashMap.capacity;
-    int32_t elementIndex = context->layoutElementsHashMap.internalArray[hashBucket];
-    while (elementIndex != -1) {
-        Clay_LayoutElementHashMapItem *hashEntry = Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, elementIndex);
-        if (hashEntry->elementId.id == id) {
-            return hashEntry;
+    int32_t hashItemIndex = Clay__FindLayoutElementHashMapSlot(id);
+    if (hashItemIndex == -1) {
+        return &Clay_LayoutElementHashMapItem_DEFAULT;
+    }
+    return Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, hashItemIndex);
+}
+
+Clay__ScrollContainerDataInternal *Clay__GetScrollContainerData(uint32_t id) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    int32_t index = Clay__GetHashMapItem(id)->scrollContainerDataIndex;
+    if (index < context->scrollContainerDatas.length && context->scrollContainerDatas.internalArray[index].elementId == id) {
+        return &context->scrollContainerDatas.internalArray[index];
+    }
+    return CLAY__NULL;
+}
+
+void Clay__RemoveScrollContainerData(int32_t index) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__ScrollContainerDataInternalArray_RemoveSwapback(&context->scrollContainerDatas, index);
+    if (index < context->scrollContainerDatas.length) {
+        Clay_LayoutElementHashMapItem *movedItem = Clay__GetHashMapItem(context->scrollContainerDatas.internalArray[index].elementId);
+        if (movedItem != &Clay_LayoutElementHashMapItem_DEFAULT) {
+            movedItem->scrollContainerDataIndex = index;
         }
-        elementIndex = hashEntry->nextIndex;
     }
-    return &Clay_LayoutElementHashMapItem_DEFAULT;
 }
 
 Clay_ElementId Clay__GenerateIdForAnonymousElement(Clay_LayoutElement *openLayoutElement) {
@@ -1589,14 +2125,6 @@ Clay_ElementId Clay__GenerateIdForAnonymousElement(Clay_LayoutElement *openLayou
     return elementId;
 }
 
-bool Clay__ElementHasConfig(Clay_LayoutElement *layoutElement, Clay__ElementConfigType type) {
-    for (int32_t i = 0; i < layoutElement->elementConfigs.length; i++) {
-        if (Clay__ElementConfigArraySlice_Get(&layoutElement->elementConfigs, i)->type == type) {
-            return true;
-        }
-    }
-    return false;
-}
 
 void Clay__CloseElement(void) {
     Clay_Context* context = Clay_GetCurrentContext();
@@ -1618,6 +2146,7 @@ void Clay__CloseElement(void) {
     }
 
     // Attach children to the current open element
+    uint32_t declarationHash = openLayoutElement->declarationHash;
     openLayoutElement->childrenOrTextContent.children.elements = &context->layoutElementChildren.internalArray[context->layoutElementChildren.length];
     if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
         openLayoutElement->dimensions.width = (float)(layoutConfig->padding.left + layoutConfig->padding.right);
@@ -1626,6 +2155,7 @@ void Clay__CloseElement(void) {
             Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, childIndex);
             openLayoutElement->dimensions.width += child->dimensions.width;
             openLayoutElement->dimensions.height = CLAY__MAX(openLayoutElement->dimensions.height, child->dimensions.height + layoutConfig->padding.top + layoutConfig->padding.bottom);
+            declarationHash = Clay__HashMix(declarationHash, child->declarationHash);
             // Minimum size of child elements doesn't matter to scroll containers as they can shrink and hide their contents
             if (!elementHasScrollHorizontal) {
                 openLayoutElement->minDimensions.width += child->minDimensions.width;
@@ -1646,6 +2176,7 @@ void Clay__CloseElement(void) {
             Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, childIndex);
             openLayoutElement->dimensions.height += child->dimensions.height;
             openLayoutElement->dimensions.width = CLAY__MAX(openLayoutElement->dimensions.width, child->dimensions.width + layoutConfig->padding.left + layoutConfig->padding.right);
+            declarationHash = Clay__HashMix(declarationHash, child->declarationHash);
             // Minimum size of child elements doesn't matter to scroll containers as they can shrink and hide their contents
             if (!elementHasScrollVertical) {
                 openLayoutElement->minDimensions.height += child->minDimensions.height;
@@ -1661,6 +2192,7 @@ void Clay__CloseElement(void) {
     }
 
     context->layoutElementChildrenBuffer.length -= openLayoutElement->childrenOrTextContent.children.length;
+    openLayoutElement->declarationHash = Clay__HashFinalize(declarationHash);
 
     // Clamp element min and max width to the values configured in the layout
     if (layoutConfig->sizing.width.type != CLAY__SIZING_TYPE_PERCENT) {
@@ -1802,12 +2334,16 @@ void Clay__OpenTextElement(Clay_String text, Clay_TextElementConfig *textConfig)
     Clay_Dimensions textDimensions = { .width = textMeasured->unwrappedDimensions.width, .height = textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textMeasured->unwrappedDimensions.height };
     textElement->dimensions = textDimensions;
     textElement->minDimensions = CLAY__INIT(Clay_Dimensions) { .width = textMeasured->unwrappedDimensions.height, .height = textDimensions.height }; // TODO not sure this is the best way to decide min width for text
-    textElement->childrenOrTextContent.textElementData = Clay__TextElementDataArray_Add(&context->textElementData, CLAY__INIT(Clay__TextElementData) { .text = text, .preferredDimensions = textMeasured->unwrappedDimensions, .elementIndex = context->layoutElements.length - 1 });
+    textElement->childrenOrTextContent.textElementData = Clay__TextElementDataArray_Add(&context->textElementData, CLAY__INIT(Clay__TextElementData) { .text = text, .preferredDimensions = textMeasured->unwrappedDimensions, .elementIndex = context->layoutElements.length - 1, .measureTextCacheItem = textMeasured });
     textElement->elementConfigs = CLAY__INIT(Clay__ElementConfigArraySlice) {
             .length = 1,
             .internalArray = Clay__ElementConfigArray_Add(&context->elementConfigs, CLAY__INIT(Clay_ElementConfig) { .type = CLAY__ELEMENT_CONFIG_TYPE_TEXT, .config = { .textElementConfig = textConfig }})
     };
+    textElement->elementConfigTypes = 1 << CLAY__ELEMENT_CONFIG_TYPE_TEXT;
     textElement->layoutConfig = &CLAY_LAYOUT_DEFAULT;
+    if (Clay__RetainedLayoutActive(context)) {
+        textElement->declarationHash = Clay__HashFinalize(Clay__HashElementDeclaration(textElement, CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT));
+    }
     parentElement->childrenOrTextContent.children.length++;
 }
 
@@ -1910,40 +2446,49 @@ void Clay__ConfigureOpenElement(const Clay_ElementDeclaration declaration) {
         openLayoutElementId = Clay__GenerateIdForAnonymousElement(openLayoutElement);
     }
 
+    Clay_Vector2 scrollPosition = CLAY__DEFAULT_STRUCT;
     if (declaration.scroll.horizontal | declaration.scroll.vertical) {
         Clay__AttachElementConfig(CLAY__INIT(Clay_ElementConfigUnion) { .scrollElementConfig = Clay__StoreScrollElementConfig(declaration.scroll) }, CLAY__ELEMENT_CONFIG_TYPE_SCROLL);
         Clay__int32_tArray_Add(&context->openClipElementStack, (int)openLayoutElement->id);
         // Retrieve or create cached data to track scroll position across frames
-        Clay__ScrollContainerDataInternal *scrollOffset = CLAY__NULL;
-        for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
-            Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-            if (openLayoutElement->id == mapping->elementId) {
-                scrollOffset = mapping;
-                scrollOffset->layoutElement = openLayoutElement;
-                scrollOffset->openThisFrame = true;
-            }
-        }
-        if (!scrollOffset) {
+        Clay__ScrollContainerDataInternal *scrollOffset = Clay__GetScrollContainerData(openLayoutElement->id);
+        if (scrollOffset) {
+            scrollOffset->layoutElement = openLayoutElement;
+            scrollOffset->openThisFrame = true;
+        } else {
             scrollOffset = Clay__ScrollContainerDataInternalArray_Add(&context->scrollContainerDatas, CLAY__INIT(Clay__ScrollContainerDataInternal){.layoutElement = openLayoutElement, .scrollOrigin = {-1,-1}, .elementId = openLayoutElement->id, .openThisFrame = true});
+            Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(openLayoutElement->id);
+            if (scrollOffset != &Clay__ScrollContainerDataInternal_DEFAULT && hashMapItem != &Clay_LayoutElementHashMapItem_DEFAULT) {
+                hashMapItem->scrollContainerDataIndex = (int32_t)context->scrollContainerDatas.length - 1;
+            }
         }
         if (context->externalScrollHandlingEnabled) {
             scrollOffset->scrollPosition = Clay__QueryScrollOffset(scrollOffset->elementId, context->queryScrollOffsetUserData);
         }
+        scrollPosition = scrollOffset->scrollPosition;
     }
     if (!Clay__MemCmp((char *)(&declaration.border.width), (char *)(&Clay__BorderWidth_DEFAULT), sizeof(Clay_BorderWidth))) {
         Clay__AttachElementConfig(CLAY__INIT(Clay_ElementConfigUnion) { .borderElementConfig = Clay__StoreBorderElementConfig(declaration.border) }, CLAY__ELEMENT_CONFIG_TYPE_BORDER);
     }
+    if (Clay__RetainedLayoutActive(context)) {
+        openLayoutElement->declarationHash = Clay__HashElementDeclaration(openLayoutElement, scrollPosition);
+    }
 }
 
 void Clay__InitializeEphemeralMemory(Clay_Context* context) {
     int32_t maxElementCount = context->maxElementCount;
+    if (context->adaptiveMemoryEnabled) {
+        maxElementCount = CLAY__MIN(maxElementCount, context->ephemeralHighWaterMark + context->ephemeralHighWaterMark / 2 + 64);
+    }
+    context->ephemeralElementCapacity = maxElementCount;
     // Ephemeral Memory - reset every frame
     Clay_Arena *arena = &context->internalArena;
     arena->nextAllocation = context->arenaResetOffset;
 
+    context->warnings = Clay__WarningArray_Allocate_Arena(100, arena);
+    context->adaptiveArraysStart = arena->nextAllocation;
     context->layoutElementChildrenBuffer = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->layoutElements = Clay_LayoutElementArray_Allocate_Arena(maxElementCount, arena);
-    context->warnings = Clay__WarningArray_Allocate_Arena(100, arena);
 
     context->layoutConfigs = Clay__LayoutConfigArray_Allocate_Arena(maxElementCount, arena);
     context->elementConfigs = Clay__ElementConfigArray_Allocate_Arena(maxElementCount, arena);
@@ -1969,7 +2514,38 @@ void Clay__InitializeEphemeralMemory(Clay_Context* context) {
     context->openClipElementStack = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->reusableElementIndexBuffer = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->layoutElementClipElementIds = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->layoutElementSizes = Clay__floatArray_Allocate_Arena(maxElementCount, arena);
+    context->layoutElementMinSizes = Clay__floatArray_Allocate_Arena(maxElementCount, arena);
+    context->layoutElementSizings = Clay__SizingAxisArray_Allocate_Arena(maxElementCount, arena);
+    context->layoutElementSizingFlags = Clay__uint8_tArray_Allocate_Arena(maxElementCount, arena);
+    context->sizeDistributionBuffer = Clay__floatArray_Allocate_Arena(maxElementCount * 2, arena);
     context->dynamicStringData = Clay__charArray_Allocate_Arena(maxElementCount, arena);
+    context->adaptiveArraysEnd = arena->nextAllocation;
+    // Only allocated while diffing is enabled and reserved. The previous frame may have used the full capacity even when this one is adaptively reduced
+    int32_t diffCapacity = Clay__RenderCommandDiffActive(context) ? context->maxElementCount : 0;
+    int32_t diffTableCapacity = diffCapacity > 0 ? 1 : 0;
+    while (diffTableCapacity > 0 && diffTableCapacity < diffCapacity * 2) {
+        diffTableCapacity *= 2;
+    }
+    context->renderCommandDiffBuffer = Clay_RenderCommandArray_Allocate_Arena(diffCapacity * 2, arena);
+    context->renderCommandDiffTable = Clay__int32_tArray_Allocate_Arena(diffTableCapacity, arena);
+    context->renderCommandDiffMatches = Clay__int32_tArray_Allocate_Arena(diffCapacity, arena);
+    context->renderCommandDiffMatched = Clay__boolArray_Allocate_Arena(diffCapacity, arena);
+    context->renderCommandDiffTextHashes = Clay__uint32_tArray_Allocate_Arena(diffCapacity, arena);
+    context->renderCommandDiff = CLAY__INIT(Clay_RenderCommandDiff) CLAY__DEFAULT_STRUCT;
+    // The packed stream lives in persistent memory, but only describes a single frame
+    context->packedRenderCommands.length = 0;
+    context->packedRenderCommandData.length = 0;
+}
+
+bool Clay__EphemeralCapacityReduced(Clay_Context* context) {
+    return context->ephemeralElementCapacity < context->maxElementCount;
+}
+
+// Whether the array is one of the per element ephemeral arrays, and was allocated this frame with less than the full capacity
+bool Clay__IsReducedAdaptiveArray(Clay_Context* context, const void *internalArray) {
+    uintptr_t offset = (uintptr_t)internalArray - (uintptr_t)context->internalArena.memory;
+    return Clay__EphemeralCapacityReduced(context) && offset >= context->adaptiveArraysStart && offset < context->adaptiveArraysEnd;
 }
 
 void Clay__InitializePersistentMemory(Clay_Context* context) {
@@ -1978,65 +2554,210 @@ void Clay__InitializePersistentMemory(Clay_Context* context) {
     int32_t maxMeasureTextCacheWordCount = context->maxMeasureTextCacheWordCount;
     Clay_Arena *arena = &context->internalArena;
 
-    context->scrollContainerDatas = Clay__ScrollContainerDataInternalArray_Allocate_Arena(10, arena);
+    context->scrollContainerDatas = Clay__ScrollContainerDataInternalArray_Allocate_Arena(context->maxScrollContainerCount, arena);
     context->layoutElementsHashMapInternal = Clay__LayoutElementHashMapItemArray_Allocate_Arena(maxElementCount, arena);
-    context->layoutElementsHashMap = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    // Keep the slot array at most half full, so that robin hood probe sequences stay short
+    int32_t layoutElementsHashMapCapacity = 1;
+    while (layoutElementsHashMapCapacity < maxElementCount * 2) {
+        layoutElementsHashMapCapacity *= 2;
+    }
+    context->layoutElementsHashMap = Clay__LayoutElementHashMapSlotArray_Allocate_Arena(layoutElementsHashMapCapacity, arena);
     context->measureTextHashMapInternal = Clay__MeasureTextCacheItemArray_Allocate_Arena(maxElementCount, arena);
     context->measureTextHashMapInternalFreeList = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
-    context->measuredWordsFreeList = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measuredWordRunOwners = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->wrappedLinesCache = Clay__MeasuredWordArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
     context->measureTextHashMap = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->measuredWords = Clay__MeasuredWordArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
     context->pointerOverIds = Clay__ElementIdArray_Allocate_Arena(maxElementCount, arena);
     context->debugElementData = Clay__DebugElementDataArray_Allocate_Arena(maxElementCount, arena);
+    // Only reserved while retained layout is enabled, see Clay_SetRetainedLayoutEnabled()
+    context->retainedRenderCommands = Clay_RenderCommandArray_Allocate_Arena(context->retainedLayoutEnabled ? maxElementCount : 0, arena);
+    // Only reserved while render command diffing is enabled, see Clay_SetRenderCommandDiffEnabled()
+    context->previousRenderCommands = Clay_RenderCommandArray_Allocate_Arena(context->renderCommandDiffEnabled ? maxElementCount : 0, arena);
+    context->previousRenderCommandTextHashes = Clay__uint32_tArray_Allocate_Arena(context->renderCommandDiffEnabled ? maxElementCount : 0, arena);
+    // Only reserved while packed render commands are enabled, see Clay_SetPackedRenderCommandsEnabled()
+    context->packedRenderCommands = Clay__PackedRenderCommandArray_Allocate_Arena(context->packedRenderCommandsEnabled ? maxElementCount : 0, arena);
+    context->packedRenderCommandData = Clay__PackedRenderCommandDataArray_Allocate_Arena(context->packedRenderCommandsEnabled ? maxElementCount : 0, arena);
     context->arenaResetOffset = arena->nextAllocation;
 }
 
-void Clay__CompressChildrenAlongAxis(bool xAxis, float totalSizeToDistribute, Clay__int32_tArray resizableContainerBuffer) {
+// Gathers the hot sizing data for one axis into contiguous arrays indexed by layout element index, so the sizing passes don't pull whole layout elements through the cache
+void Clay__GatherLayoutElementSizing(bool xAxis) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay__int32_tArray largestContainers = context->openClipElementStack;
-
-    while (totalSizeToDistribute > 0.1) {
-        largestContainers.length = 0;
-        float largestSize = 0;
-        float targetSize = 0;
-        for (int32_t i = 0; i < resizableContainerBuffer.length; ++i) {
-            Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, i));
-            float childSize = xAxis ? childElement->dimensions.width : childElement->dimensions.height;
-            if ((childSize - largestSize) < 0.1 && (childSize - largestSize) > -0.1) {
-                Clay__int32_tArray_Add(&largestContainers, Clay__int32_tArray_GetValue(&resizableContainerBuffer, i));
-            } else if (childSize > largestSize) {
-                targetSize = largestSize;
-                largestSize = childSize;
-                largestContainers.length = 0;
-                Clay__int32_tArray_Add(&largestContainers, Clay__int32_tArray_GetValue(&resizableContainerBuffer, i));
-            }
-            else if (childSize > targetSize) {
-                targetSize = childSize;
+    float *sizes = context->layoutElementSizes.internalArray;
+    float *minSizes = context->layoutElementMinSizes.internalArray;
+    Clay_SizingAxis *sizings = context->layoutElementSizings.internalArray;
+    uint8_t *sizingFlags = context->layoutElementSizingFlags.internalArray;
+    for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+        Clay_LayoutElement *layoutElement = &context->layoutElements.internalArray[i];
+        sizes[i] = xAxis ? layoutElement->dimensions.width : layoutElement->dimensions.height;
+        minSizes[i] = xAxis ? layoutElement->minDimensions.width : layoutElement->minDimensions.height;
+        sizings[i] = xAxis ? layoutElement->layoutConfig->sizing.width : layoutElement->layoutConfig->sizing.height;
+        uint8_t flags = 0;
+        if (Clay__ElementHasConfig(layoutElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+            flags |= CLAY__SIZING_FLAG_TEXT;
+            if (Clay__FindElementConfigWithType(layoutElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig->wrapMode == CLAY_TEXT_WRAP_WORDS) {
+                flags |= CLAY__SIZING_FLAG_TEXT_WRAP_WORDS;
             }
+        } else if (layoutElement->childrenOrTextContent.children.length > 0) {
+            flags |= CLAY__SIZING_FLAG_HAS_CHILDREN;
+        }
+        if (Clay__ElementHasConfig(layoutElement, CLAY__ELEMENT_CONFIG_TYPE_IMAGE)) {
+            flags |= CLAY__SIZING_FLAG_IMAGE;
+        }
+        if (Clay__ElementHasConfig(layoutElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL)) {
+            Clay_ScrollElementConfig *scrollConfig = Clay__FindElementConfigWithType(layoutElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig;
+            flags |= scrollConfig->horizontal ? CLAY__SIZING_FLAG_SCROLL_HORIZONTAL : 0;
+            flags |= scrollConfig->vertical ? CLAY__SIZING_FLAG_SCROLL_VERTICAL : 0;
+        }
+        sizingFlags[i] = flags;
+    }
+    context->layoutElementSizes.length = context->layoutElements.length;
+    context->layoutElementMinSizes.length = context->layoutElements.length;
+    context->layoutElementSizings.length = context->layoutElements.length;
+    context->layoutElementSizingFlags.length = context->layoutElements.length;
+}
+
+void Clay__ScatterLayoutElementSizing(bool xAxis) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    float *sizes = context->layoutElementSizes.internalArray;
+    for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+        Clay_Dimensions *dimensions = &context->layoutElements.internalArray[i].dimensions;
+        if (xAxis) {
+            dimensions->width = sizes[i];
+        } else {
+            dimensions->height = sizes[i];
         }
+    }
+}
 
-        if (largestContainers.length == 0) {
+void Clay__SiftDownFloatMinHeap(float *values, int32_t root, int32_t length) {
+    while (root * 2 + 1 < length) {
+        int32_t child = root * 2 + 1;
+        if (child + 1 < length && values[child + 1] < values[child]) {
+            child++;
+        }
+        if (values[root] <= values[child]) {
             return;
         }
+        float temp = values[root];
+        values[root] = values[child];
+        values[child] = temp;
+        root = child;
+    }
+}
+
+// In place heap sort, largest value first
+void Clay__SortFloatsDescending(float *values, int32_t length) {
+    for (int32_t i = length / 2 - 1; i >= 0; --i) {
+        Clay__SiftDownFloatMinHeap(values, i, length);
+    }
+    for (int32_t end = length - 1; end > 0; --end) {
+        // Move the smallest remaining value to the back
+        float temp = values[0];
+        values[0] = values[end];
+        values[end] = temp;
+        Clay__SiftDownFloatMinHeap(values, 0, end);
+    }
+}
+
+// Shrinks the largest children first, down to a common "water level" that removes exactly totalSizeToDistribute, without taking any child below its minimum.
+// Every child ends up at min(size, max(minSize, level)). The total removed is piecewise linear in the level, changing slope only at a child's size or
+// minimum size, so the level is found with a single descending walk over those sorted breakpoints.
+void Clay__CompressChildrenAlongAxis(float totalSizeToDistribute, Clay__int32_tArray resizableContainerBuffer) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    float *sizes = context->layoutElementSizes.internalArray;
+    float *minSizes = context->layoutElementMinSizes.internalArray;
+    float *shrinkableSizes = context->sizeDistributionBuffer.internalArray;
+    int32_t shrinkableCount = 0;
+    for (int32_t i = 0; i < resizableContainerBuffer.length; ++i) {
+        int32_t childIndex = resizableContainerBuffer.internalArray[i];
+        if (sizes[childIndex] > minSizes[childIndex]) {
+            shrinkableSizes[shrinkableCount++] = sizes[childIndex];
+        }
+    }
+    if (shrinkableCount == 0) {
+        return;
+    }
+    float *shrinkableMinSizes = shrinkableSizes + shrinkableCount;
+    int32_t minSizeCount = 0;
+    for (int32_t i = 0; i < resizableContainerBuffer.length; ++i) {
+        int32_t childIndex = resizableContainerBuffer.internalArray[i];
+        if (sizes[childIndex] > minSizes[childIndex]) {
+            shrinkableMinSizes[minSizeCount++] = minSizes[childIndex];
+        }
+    }
+    Clay__SortFloatsDescending(shrinkableSizes, shrinkableCount);
+    Clay__SortFloatsDescending(shrinkableMinSizes, shrinkableCount);
+
+    // Walk the level down from the largest child. activeCount is the number of children currently shrinking along with the level.
+    float level = shrinkableSizes[0];
+    float removed = 0;
+    int32_t activeCount = 0;
+    int32_t sizeIndex = 0, minSizeIndex = 0;
+    bool levelFound = false;
+    while (minSizeIndex < shrinkableCount) {
+        bool nextIsSize = sizeIndex < shrinkableCount && shrinkableSizes[sizeIndex] >= shrinkableMinSizes[minSizeIndex];
+        float nextLevel = nextIsSize ? shrinkableSizes[sizeIndex] : shrinkableMinSizes[minSizeIndex];
+        float removedAtNextLevel = removed + (level - nextLevel) * (float)activeCount;
+        if (activeCount > 0 && removedAtNextLevel >= totalSizeToDistribute) {
+            level -= (totalSizeToDistribute - removed) / (float)activeCount;
+            levelFound = true;
+            break;
+        }
+        removed = removedAtNextLevel;
+        level = nextLevel;
+        if (nextIsSize) {
+            activeCount++;
+            sizeIndex++;
+        } else {
+            activeCount--;
+            minSizeIndex++;
+        }
+    }
 
-        targetSize = CLAY__MAX(targetSize, (largestSize * largestContainers.length) - totalSizeToDistribute) / largestContainers.length;
-
-        for (int32_t childOffset = 0; childOffset < largestContainers.length; childOffset++) {
-            int32_t childIndex = Clay__int32_tArray_GetValue(&largestContainers, childOffset);
-            Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childIndex);
-            float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
-            float childMinSize = xAxis ? childElement->minDimensions.width : childElement->minDimensions.height;
-            float oldChildSize = *childSize;
-            *childSize = CLAY__MAX(childMinSize, targetSize);
-            totalSizeToDistribute -= (oldChildSize - *childSize);
-            if (*childSize == childMinSize) {
-                for (int32_t i = 0; i < resizableContainerBuffer.length; i++) {
-                    if (Clay__int32_tArray_GetValue(&resizableContainerBuffer, i) == childIndex) {
-                        Clay__int32_tArray_RemoveSwapback(&resizableContainerBuffer, i);
-                        break;
-                    }
-                }
+    for (int32_t i = 0; i < resizableContainerBuffer.length; ++i) {
+        int32_t childIndex = resizableContainerBuffer.internalArray[i];
+        if (sizes[childIndex] > minSizes[childIndex]) {
+            // If even the minimum sizes don't fit, every child is compressed to its minimum
+            sizes[childIndex] = levelFound ? CLAY__MIN(sizes[childIndex], CLAY__MAX(minSizes[childIndex], level)) : minSizes[childIndex];
+        }
+    }
+}
+
+// Shares the free space between grow children as an equal target size. Children whose minimum size is larger than the target keep their minimum and
+// drop out of the share, which lowers the target - so the children that drop out are always a prefix of the grow children sorted by minimum size.
+void Clay__GrowChildrenAlongAxis(float sizeToDistribute, float growContainerContentSize, int32_t growContainerCount, Clay__int32_tArray resizableContainerBuffer) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    float *sizes = context->layoutElementSizes.internalArray;
+    float *minSizes = context->layoutElementMinSizes.internalArray;
+    Clay_SizingAxis *sizings = context->layoutElementSizings.internalArray;
+    float targetSize = (sizeToDistribute + growContainerContentSize) / (float)growContainerCount;
+    float *growMinSizes = context->sizeDistributionBuffer.internalArray;
+    int32_t growMinSizeCount = 0;
+    for (int32_t i = 0; i < resizableContainerBuffer.length; ++i) {
+        int32_t childIndex = resizableContainerBuffer.internalArray[i];
+        if (sizings[childIndex].type == CLAY__SIZING_TYPE_GROW) {
+            growMinSizes[growMinSizeCount++] = minSizes[childIndex];
+        }
+    }
+    if (growMinSizeCount > 0) {
+        // A child whose minimum is above the target keeps its minimum, which lowers the target for the others and can push more minimums
+        // above it. Dropping them largest first repeats that until no remaining minimum is above the target.
+        Clay__SortFloatsDescending(growMinSizes, growMinSizeCount);
+        for (int32_t i = 0; i < growMinSizeCount && growMinSizes[i] > targetSize; ++i) {
+            growContainerContentSize -= growMinSizes[i];
+            growContainerCount--;
+            if (growContainerCount == 0) {
+                return;
             }
+            targetSize = (sizeToDistribute + growContainerContentSize) / (float)growContainerCount;
+        }
+    }
+    for (int32_t i = 0; i < resizableContainerBuffer.length; ++i) {
+        int32_t childIndex = resizableContainerBuffer.internalArray[i];
+        if (sizings[childIndex].type == CLAY__SIZING_TYPE_GROW && minSizes[childIndex] <= targetSize) {
+            sizes[childIndex] = targetSize;
         }
     }
 }
@@ -2045,11 +2766,20 @@ void Clay__SizeContainersAlongAxis(bool xAxis) {
     Clay_Context* context = Clay_GetCurrentContext();
     Clay__int32_tArray bfsBuffer = context->layoutElementChildrenBuffer;
     Clay__int32_tArray resizableContainerBuffer = context->openLayoutElementStack;
+    Clay__GatherLayoutElementSizing(xAxis);
+    float *sizes = context->layoutElementSizes.internalArray;
+    Clay_SizingAxis *sizings = context->layoutElementSizings.internalArray;
+    uint8_t *sizingFlags = context->layoutElementSizingFlags.internalArray;
+    uint8_t scrollFlag = xAxis ? CLAY__SIZING_FLAG_SCROLL_HORIZONTAL : CLAY__SIZING_FLAG_SCROLL_VERTICAL;
     for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
         bfsBuffer.length = 0;
         Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
-        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)root->layoutElementIndex);
-        Clay__int32_tArray_Add(&bfsBuffer, (int32_t)root->layoutElementIndex);
+        int32_t rootElementIndex = (int32_t)root->layoutElementIndex;
+        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, rootElementIndex);
+        Clay__int32_tArray_Add(&bfsBuffer, rootElementIndex);
+        // The off axis of root elements is still read and written directly, as it isn't gathered for this pass
+        Clay_SizingAxis rootOffAxisSizing = xAxis ? rootElement->layoutConfig->sizing.height : rootElement->layoutConfig->sizing.width;
+        float *rootOffAxisSize = xAxis ? &rootElement->dimensions.height : &rootElement->dimensions.width;
 
         // Size floating containers to their parents
         if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
@@ -2057,44 +2787,45 @@ void Clay__SizeContainersAlongAxis(bool xAxis) {
             Clay_LayoutElementHashMapItem *parentItem = Clay__GetHashMapItem(floatingElementConfig->parentId);
             if (parentItem && parentItem != &Clay_LayoutElementHashMapItem_DEFAULT) {
                 Clay_LayoutElement *parentLayoutElement = parentItem->layoutElement;
-                if (rootElement->layoutConfig->sizing.width.type == CLAY__SIZING_TYPE_GROW) {
-                    rootElement->dimensions.width = parentLayoutElement->dimensions.width;
+                if (sizings[rootElementIndex].type == CLAY__SIZING_TYPE_GROW) {
+                    sizes[rootElementIndex] = sizes[parentLayoutElement - context->layoutElements.internalArray];
                 }
-                if (rootElement->layoutConfig->sizing.height.type == CLAY__SIZING_TYPE_GROW) {
-                    rootElement->dimensions.height = parentLayoutElement->dimensions.height;
+                if (rootOffAxisSizing.type == CLAY__SIZING_TYPE_GROW) {
+                    *rootOffAxisSize = xAxis ? parentLayoutElement->dimensions.height : parentLayoutElement->dimensions.width;
                 }
             }
         }
 
-        rootElement->dimensions.width = CLAY__MIN(CLAY__MAX(rootElement->dimensions.width, rootElement->layoutConfig->sizing.width.size.minMax.min), rootElement->layoutConfig->sizing.width.size.minMax.max);
-        rootElement->dimensions.height = CLAY__MIN(CLAY__MAX(rootElement->dimensions.height, rootElement->layoutConfig->sizing.height.size.minMax.min), rootElement->layoutConfig->sizing.height.size.minMax.max);
+        sizes[rootElementIndex] = CLAY__MIN(CLAY__MAX(sizes[rootElementIndex], sizings[rootElementIndex].size.minMax.min), sizings[rootElementIndex].size.minMax.max);
+        *rootOffAxisSize = CLAY__MIN(CLAY__MAX(*rootOffAxisSize, rootOffAxisSizing.size.minMax.min), rootOffAxisSizing.size.minMax.max);
 
         for (int32_t i = 0; i < bfsBuffer.length; ++i) {
             int32_t parentIndex = Clay__int32_tArray_GetValue(&bfsBuffer, i);
             Clay_LayoutElement *parent = Clay_LayoutElementArray_Get(&context->layoutElements, parentIndex);
             Clay_LayoutConfig *parentStyleConfig = parent->layoutConfig;
             int32_t growContainerCount = 0;
-            float parentSize = xAxis ? parent->dimensions.width : parent->dimensions.height;
+            float parentSize = sizes[parentIndex];
             float parentPadding = (float)(xAxis ? (parent->layoutConfig->padding.left + parent->layoutConfig->padding.right) : (parent->layoutConfig->padding.top + parent->layoutConfig->padding.bottom));
             float innerContentSize = 0, growContainerContentSize = 0, totalPaddingAndChildGaps = parentPadding;
             bool sizingAlongAxis = (xAxis && parentStyleConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) || (!xAxis && parentStyleConfig->layoutDirection == CLAY_TOP_TO_BOTTOM);
+            bool parentScrollsAlongAxis = sizingFlags[parentIndex] & scrollFlag;
             resizableContainerBuffer.length = 0;
             float parentChildGap = parentStyleConfig->childGap;
 
             for (int32_t childOffset = 0; childOffset < parent->childrenOrTextContent.children.length; childOffset++) {
                 int32_t childElementIndex = parent->childrenOrTextContent.children.elements[childOffset];
-                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
-                Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
-                float childSize = xAxis ? childElement->dimensions.width : childElement->dimensions.height;
+                Clay_SizingAxis childSizing = sizings[childElementIndex];
+                float childSize = sizes[childElementIndex];
+                uint8_t childFlags = sizingFlags[childElementIndex];
 
-                if (!Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) && childElement->childrenOrTextContent.children.length > 0) {
+                if (childFlags & CLAY__SIZING_FLAG_HAS_CHILDREN) {
                     Clay__int32_tArray_Add(&bfsBuffer, childElementIndex);
                 }
 
                 if (childSizing.type != CLAY__SIZING_TYPE_PERCENT
                     && childSizing.type != CLAY__SIZING_TYPE_FIXED
-                    && (!Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) || (Clay__FindElementConfigWithType(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig->wrapMode == CLAY_TEXT_WRAP_WORDS)) // todo too many loops
-                    && (xAxis || !Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_IMAGE))
+                    && (!(childFlags & CLAY__SIZING_FLAG_TEXT) || (childFlags & CLAY__SIZING_FLAG_TEXT_WRAP_WORDS))
+                    && (xAxis || !(childFlags & CLAY__SIZING_FLAG_IMAGE))
                 ) {
                     Clay__int32_tArray_Add(&resizableContainerBuffer, childElementIndex);
                 }
@@ -2117,13 +2848,11 @@ void Clay__SizeContainersAlongAxis(bool xAxis) {
             // Expand percentage containers to size
             for (int32_t childOffset = 0; childOffset < parent->childrenOrTextContent.children.length; childOffset++) {
                 int32_t childElementIndex = parent->childrenOrTextContent.children.elements[childOffset];
-                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
-                Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
-                float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
+                Clay_SizingAxis childSizing = sizings[childElementIndex];
                 if (childSizing.type == CLAY__SIZING_TYPE_PERCENT) {
-                    *childSize = (parentSize - totalPaddingAndChildGaps) * childSizing.size.percent;
+                    sizes[childElementIndex] = (parentSize - totalPaddingAndChildGaps) * childSizing.size.percent;
                     if (sizingAlongAxis) {
-                        innerContentSize += *childSize;
+                        innerContentSize += sizes[childElementIndex];
                     }
                 }
             }
@@ -2133,53 +2862,30 @@ void Clay__SizeContainersAlongAxis(bool xAxis) {
                 // The content is too large, compress the children as much as possible
                 if (sizeToDistribute < 0) {
                     // If the parent can scroll in the axis direction in this direction, don't compress children, just leave them alone
-                    Clay_ScrollElementConfig *scrollElementConfig = Clay__FindElementConfigWithType(parent, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig;
-                    if (scrollElementConfig) {
-                        if (((xAxis && scrollElementConfig->horizontal) || (!xAxis && scrollElementConfig->vertical))) {
-                            continue;
-                        }
+                    if (parentScrollsAlongAxis) {
+                        continue;
                     }
                     // Scrolling containers preferentially compress before others
-                    Clay__CompressChildrenAlongAxis(xAxis, -sizeToDistribute, resizableContainerBuffer);
+                    Clay__CompressChildrenAlongAxis(-sizeToDistribute, resizableContainerBuffer);
                 // The content is too small, allow SIZING_GROW containers to expand
                 } else if (sizeToDistribute > 0 && growContainerCount > 0) {
-                    float targetSize = (sizeToDistribute + growContainerContentSize) / (float)growContainerCount;
-                    for (int32_t childOffset = 0; childOffset < resizableContainerBuffer.length; childOffset++) {
-                        Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childOffset));
-                        Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
-                        if (childSizing.type == CLAY__SIZING_TYPE_GROW) {
-                            float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
-                            float *minSize = xAxis ? &childElement->minDimensions.width : &childElement->minDimensions.height;
-                            if (targetSize < *minSize) {
-                                growContainerContentSize -= *minSize;
-                                Clay__int32_tArray_RemoveSwapback(&resizableContainerBuffer, childOffset);
-                                growContainerCount--;
-                                targetSize = (sizeToDistribute + growContainerContentSize) / (float)growContainerCount;
-                                childOffset = -1;
-                                continue;
-                            }
-                            *childSize = targetSize;
-                        }
-                    }
+                    Clay__GrowChildrenAlongAxis(sizeToDistribute, growContainerContentSize, growContainerCount, resizableContainerBuffer);
                 }
             // Sizing along the non layout axis ("off axis")
             } else {
                 for (int32_t childOffset = 0; childOffset < resizableContainerBuffer.length; childOffset++) {
-                    Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childOffset));
-                    Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
-                    float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
+                    int32_t childElementIndex = resizableContainerBuffer.internalArray[childOffset];
+                    Clay_SizingAxis childSizing = sizings[childElementIndex];
+                    float *childSize = &sizes[childElementIndex];
 
-                    if (!xAxis && Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_IMAGE)) {
+                    if (!xAxis && (sizingFlags[childElementIndex] & CLAY__SIZING_FLAG_IMAGE)) {
                         continue; // Currently we don't support resizing aspect ratio images on the Y axis because it would break the ratio
                     }
 
                     // If we're laying out the children of a scroll panel, grow containers expand to the height of the inner content, not the outer container
                     float maxSize = parentSize - parentPadding;
-                    if (Clay__ElementHasConfig(parent, CLAY__ELEMENT_CONFIG_TYPE_SCROLL)) {
-                        Clay_ScrollElementConfig *scrollElementConfig = Clay__FindElementConfigWithType(parent, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig;
-                        if (((xAxis && scrollElementConfig->horizontal) || (!xAxis && scrollElementConfig->vertical))) {
-                            maxSize = CLAY__MAX(maxSize, innerContentSize);
-                        }
+                    if (parentScrollsAlongAxis) {
+                        maxSize = CLAY__MAX(maxSize, innerContentSize);
                     }
                     if (childSizing.type == CLAY__SIZING_TYPE_FIT) {
                         *childSize = CLAY__MAX(childSizing.size.minMax.min, CLAY__MIN(*childSize, maxSize));
@@ -2190,6 +2896,7 @@ void Clay__SizeContainersAlongAxis(bool xAxis) {
             }
         }
     }
+    Clay__ScatterLayoutElementSizing(xAxis);
 }
 
 Clay_String Clay__IntToString(int32_t integer) {
@@ -2230,6 +2937,10 @@ void Clay__AddRenderCommand(Clay_RenderCommand renderCommand) {
     } else {
         if (!context->booleanWarnings.maxRenderCommandsExceeded) {
             context->booleanWarnings.maxRenderCommandsExceeded = true;
+            if (Clay__EphemeralCapacityReduced(context)) {
+                context->booleanWarnings.ephemeralCapacityExceeded = true;
+                return;
+            }
             context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
                 .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
                 .errorText = CLAY_STRING("Clay ran out of capacity while attempting to create render commands. This is usually caused by a large amount of wrapping text elements while close to the max element capacity. Try using Clay_SetMaxElementCount() with a higher value."),
@@ -2238,61 +2949,192 @@ void Clay__AddRenderCommand(Clay_RenderCommand renderCommand) {
     }
 }
 
-bool Clay__ElementIsOffscreen(Clay_BoundingBox *boundingBox) {
+// cullBoundingBox is the visible area the element is drawn into, usually the window intersected with any enclosing scissors
+bool Clay__ElementIsOffscreen(Clay_BoundingBox *boundingBox, Clay_BoundingBox *cullBoundingBox) {
     Clay_Context* context = Clay_GetCurrentContext();
     if (context->disableCulling) {
         return false;
     }
 
-    return (boundingBox->x > (float)context->layoutDimensions.width) ||
-           (boundingBox->y > (float)context->layoutDimensions.height) ||
-           (boundingBox->x + boundingBox->width < 0) ||
-           (boundingBox->y + boundingBox->height < 0);
+    return (cullBoundingBox->width < 0 || cullBoundingBox->height < 0) ||
+           (boundingBox->x > cullBoundingBox->x + cullBoundingBox->width) ||
+           (boundingBox->y > cullBoundingBox->y + cullBoundingBox->height) ||
+           (boundingBox->x + boundingBox->width < cullBoundingBox->x) ||
+           (boundingBox->y + boundingBox->height < cullBoundingBox->y);
 }
 
-void Clay__CalculateFinalLayout(void) {
+void Clay__SortLayoutElementTreeRoots(void) {
     Clay_Context* context = Clay_GetCurrentContext();
-    // Calculate sizing along the X axis
-    Clay__SizeContainersAlongAxis(true);
+    // Sort tree roots by z-index
+    int32_t sortMax = context->layoutElementTreeRoots.length - 1;
+    while (sortMax > 0) { // todo dumb bubble sort
+        for (int32_t i = 0; i < sortMax; ++i) {
+            Clay__LayoutElementTreeRoot current = *Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, i);
+            Clay__LayoutElementTreeRoot next = *Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, i + 1);
+            if (next.zIndex < current.zIndex) {
+                Clay__LayoutElementTreeRootArray_Set(&context->layoutElementTreeRoots, i, next);
+                Clay__LayoutElementTreeRootArray_Set(&context->layoutElementTreeRoots, i + 1, current);
+            }
+        }
+        sortMax--;
+    }
+}
 
-    // Wrap text
-    for (int32_t textElementIndex = 0; textElementIndex < context->textElementData.length; ++textElementIndex) {
-        Clay__TextElementData *textElementData = Clay__TextElementDataArray_Get(&context->textElementData, textElementIndex);
-        textElementData->wrappedLines = CLAY__INIT(Clay__WrappedTextLineArraySlice) { .length = 0, .internalArray = &context->wrappedTextLines.internalArray[context->wrappedTextLines.length] };
-        Clay_LayoutElement *containerElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)textElementData->elementIndex);
-        Clay_TextElementConfig *textConfig = Clay__FindElementConfigWithType(containerElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig;
-        Clay__MeasureTextCacheItem *measureTextCacheItem = Clay__MeasureTextCached(&textElementData->text, textConfig);
-        float lineWidth = 0;
-        float lineHeight = textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textElementData->preferredDimensions.height;
-        int32_t lineLengthChars = 0;
-        int32_t lineStartOffset = 0;
-        if (!measureTextCacheItem->containsNewlines && textElementData->preferredDimensions.width <= containerElement->dimensions.width) {
-            Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { containerElement->dimensions,  textElementData->text });
-            textElementData->wrappedLines.length++;
+// The descendants' render commands were copied along with their reused ancestor's, so their retained data is moved by the same offset,
+// keeping each of them reusable next frame even if a sibling changes
+void Clay__RebaseRetainedDescendants(Clay_LayoutElement *layoutElement, int32_t offset) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__int32_tArray dfsBuffer = context->reusableElementIndexBuffer;
+    dfsBuffer.length = 0;
+    Clay_LayoutElement *currentElement = layoutElement;
+    while (true) {
+        if (!Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+            for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; i++) {
+                Clay__int32_tArray_Add(&dfsBuffer, currentElement->childrenOrTextContent.children.elements[i]);
+            }
+        }
+        if (dfsBuffer.length == 0) {
+            break;
+        }
+        currentElement = Clay_LayoutElementArray_Get(&context->layoutElements, dfsBuffer.internalArray[--dfsBuffer.length]);
+        Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(currentElement->id);
+        // Descendants that weren't retained last frame, such as culled ones, have nothing to move
+        if (hashMapItem->layoutElement == currentElement && hashMapItem->retained.renderCommandsVersion == context->retainedRenderCommandsVersion) {
+            hashMapItem->retained.renderCommandsStart += offset;
+            hashMapItem->retained.renderCommandsVersion = context->retainedRenderCommandsVersion + 1;
+        }
+    }
+}
+
+// Copies the render commands generated for this element's subtree last frame, if neither the subtree's declaration, its final bounding box nor
+// the area it was culled against have changed
+bool Clay__ReuseRetainedRenderCommands(Clay_LayoutElementHashMapItem *hashMapItem, Clay_LayoutElement *layoutElement, Clay_BoundingBox boundingBox, Clay_BoundingBox cullBoundingBox, int16_t zIndex) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__RetainedElementData *retained = &hashMapItem->retained;
+    if (hashMapItem->layoutElement != layoutElement
+        || retained->renderCommandsVersion != context->retainedRenderCommandsVersion
+        || retained->declarationHash != layoutElement->declarationHash
+        || retained->zIndex != zIndex
+        || !Clay__MemCmp((char *)(&hashMapItem->boundingBox), (char *)(&boundingBox), sizeof(Clay_BoundingBox))
+        || !Clay__MemCmp((char *)(&retained->cullBoundingBox), (char *)(&cullBoundingBox), sizeof(Clay_BoundingBox))
+        || context->renderCommands.length + retained->renderCommandsLength >= context->renderCommands.capacity - 1) {
+        return false;
+    }
+    int32_t renderCommandsStart = context->renderCommands.length;
+    for (int32_t i = 0; i < retained->renderCommandsLength; i++) {
+        context->renderCommands.internalArray[context->renderCommands.length++] = context->retainedRenderCommands.internalArray[retained->renderCommandsStart + i];
+    }
+    Clay__RebaseRetainedDescendants(layoutElement, renderCommandsStart - retained->renderCommandsStart);
+    retained->renderCommandsStart = renderCommandsStart;
+    retained->renderCommandsVersion = context->retainedRenderCommandsVersion + 1;
+    return true;
+}
+
+void Clay__InvalidateRetainedLayout(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->retainedRenderCommandsVersion++;
+    context->retainedRenderCommands.length = 0;
+    context->retainedFrameHash = 0;
+}
+
+uint32_t Clay__HashRetainedFrame(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    uint32_t hash = context->disableCulling;
+    for (int32_t i = 0; i < context->layoutElementTreeRoots.length; i++) {
+        Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, i);
+        hash = Clay__HashMix(hash, Clay_LayoutElementArray_Get(&context->layoutElements, root->layoutElementIndex)->declarationHash);
+        hash = Clay__HashMix(hash, root->parentId);
+        hash = Clay__HashMix(hash, root->clipElementId);
+        hash = Clay__HashMix(hash, (uint16_t)root->zIndex);
+    }
+    return Clay__HashFinalize(hash) + 1; // Reserve zero as "no retained frame"
+}
+
+// Nothing has changed since the previous frame, so the retained render commands can be returned as-is
+void Clay__RestoreRetainedFrame(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__SortLayoutElementTreeRoots();
+    context->renderCommands.length = 0;
+    for (int32_t i = 0; i < context->retainedRenderCommands.length; i++) {
+        Clay_RenderCommandArray_Add(&context->renderCommands, context->retainedRenderCommands.internalArray[i]);
+    }
+    // Scroll containers read their element's final dimensions after layout, which are only otherwise available via the bounding box
+    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
+        Clay__ScrollContainerDataInternal *scrollData = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
+        if (!scrollData->openThisFrame || !scrollData->layoutElement) {
             continue;
         }
-        float spaceWidth = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars }, textConfig, context->measureTextUserData).width;
-        int32_t wordIndex = measureTextCacheItem->measuredWordsStartIndex;
-        while (wordIndex != -1) {
-            if (context->wrappedTextLines.length > context->wrappedTextLines.capacity - 1) {
-                break;
+        Clay_Dimensions expand = CLAY__DEFAULT_STRUCT;
+        if (Clay__ElementHasConfig(scrollData->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
+            expand = Clay__FindElementConfigWithType(scrollData->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig->expand;
+        }
+        scrollData->layoutElement->dimensions = CLAY__INIT(Clay_Dimensions) { scrollData->boundingBox.width - expand.width * 2, scrollData->boundingBox.height - expand.height * 2 };
+    }
+}
+
+void Clay__StoreRetainedFrame(uint32_t frameHash) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (context->booleanWarnings.maxRenderCommandsExceeded) {
+        Clay__InvalidateRetainedLayout();
+        return;
+    }
+    context->retainedRenderCommands.length = 0;
+    for (int32_t i = 0; i < context->renderCommands.length; i++) {
+        Clay_RenderCommandArray_Add(&context->retainedRenderCommands, context->renderCommands.internalArray[i]);
+    }
+    context->retainedRenderCommandsVersion++;
+    context->retainedFrameHash = frameHash;
+}
+
+void Clay__AddWrappedTextLine(Clay__WrappedTextLine *lines, int32_t maxLines, int32_t *lineCount, Clay__WrappedTextLine line) {
+    if (lines && *lineCount < maxLines) {
+        lines[*lineCount] = line;
+    }
+    (*lineCount)++;
+}
+
+// Breaks a text element's measured words into lines that fit the width of its container, writing the first maxLines of them
+// to lines and returning how many lines the text needs in total. Passing NULL for lines only counts them.
+// Reads nothing but the element's own data and the wrapped line cache, and writes nothing but its lines and height, so elements can be
+// wrapped concurrently. Lines that missed the cache are stored afterwards by Clay__StoreWrappedLines().
+int32_t Clay__WrapTextElement(Clay_Context *context, Clay__TextElementData *textElementData, Clay__WrappedTextLine *lines, int32_t maxLines) {
+    Clay_LayoutElement *containerElement = &context->layoutElements.internalArray[textElementData->elementIndex];
+    Clay_TextElementConfig *textConfig = Clay__FindElementConfigWithType(containerElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig;
+    float lineWidth = 0;
+    float lineHeight = textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textElementData->preferredDimensions.height;
+    int32_t lineLengthChars = 0;
+    int32_t lineStartOffset = 0;
+    int32_t lineCount = 0;
+    Clay__MeasureTextCacheItem *measureTextCacheItem = textElementData->measureTextCacheItem;
+    if (!measureTextCacheItem->containsNewlines && textElementData->preferredDimensions.width <= containerElement->dimensions.width) {
+        Clay__AddWrappedTextLine(lines, maxLines, &lineCount, CLAY__INIT(Clay__WrappedTextLine) { containerElement->dimensions, textElementData->text });
+    } else if (measureTextCacheItem->wrappedLinesCount > 0 && measureTextCacheItem->wrappedWidth == containerElement->dimensions.width) {
+        // Same text wrapped to the same width as last time, the lines can't have changed
+        lineCount = measureTextCacheItem->wrappedLinesCount;
+        if (lines) {
+            for (int32_t i = 0; i < CLAY__MIN(lineCount, maxLines); ++i) {
+                Clay__MeasuredWord *cachedLine = &context->wrappedLinesCache.internalArray[measureTextCacheItem->measuredWordsStartIndex + i];
+                lines[i] = CLAY__INIT(Clay__WrappedTextLine) { { cachedLine->width, lineHeight }, { .length = cachedLine->length, .chars = &textElementData->text.chars[cachedLine->startOffset] } };
             }
-            Clay__MeasuredWord *measuredWord = Clay__MeasuredWordArray_Get(&context->measuredWords, wordIndex);
+            containerElement->dimensions.height = lineHeight * (float)CLAY__MIN(lineCount, maxLines);
+        }
+    } else {
+        int32_t wordIndex = measureTextCacheItem->measuredWordsStartIndex;
+        int32_t wordsEnd = measureTextCacheItem->measuredWordsStartIndex + measureTextCacheItem->measuredWordsCount;
+        while (wordIndex < wordsEnd) {
+            Clay__MeasuredWord *measuredWord = &context->measuredWords.internalArray[wordIndex];
             // Only word on the line is too large, just render it anyway
             if (lineLengthChars == 0 && lineWidth + measuredWord->width > containerElement->dimensions.width) {
-                Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { measuredWord->width, lineHeight }, { .length = measuredWord->length, .chars = &textElementData->text.chars[measuredWord->startOffset] } });
-                textElementData->wrappedLines.length++;
-                wordIndex = measuredWord->next;
+                Clay__AddWrappedTextLine(lines, maxLines, &lineCount, CLAY__INIT(Clay__WrappedTextLine) { { measuredWord->width, lineHeight }, { .length = measuredWord->length, .chars = &textElementData->text.chars[measuredWord->startOffset] } });
+                wordIndex++;
                 lineStartOffset = measuredWord->startOffset + measuredWord->length;
             }
             // measuredWord->length == 0 means a newline character
             else if (measuredWord->length == 0 || lineWidth + measuredWord->width > containerElement->dimensions.width) {
-                // Wrapped text lines list has overflowed, just render out the line
                 bool finalCharIsSpace = textElementData->text.chars[lineStartOffset + lineLengthChars - 1] == ' ';
-                Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { lineWidth + (finalCharIsSpace ? -spaceWidth : 0), lineHeight }, { .length = lineLengthChars + (finalCharIsSpace ? -1 : 0), .chars = &textElementData->text.chars[lineStartOffset] } });
-                textElementData->wrappedLines.length++;
+                Clay__AddWrappedTextLine(lines, maxLines, &lineCount, CLAY__INIT(Clay__WrappedTextLine) { { lineWidth + (finalCharIsSpace ? -measureTextCacheItem->spaceWidth : 0), lineHeight }, { .length = lineLengthChars + (finalCharIsSpace ? -1 : 0), .chars = &textElementData->text.chars[lineStartOffset] } });
                 if (lineLengthChars == 0 || measuredWord->length == 0) {
-                    wordIndex = measuredWord->next;
+                    wordIndex++;
                 }
                 lineWidth = 0;
                 lineLengthChars = 0;
@@ -2300,15 +3142,153 @@ void Clay__CalculateFinalLayout(void) {
             } else {
                 lineWidth += measuredWord->width;
                 lineLengthChars += measuredWord->length;
-                wordIndex = measuredWord->next;
+                wordIndex++;
             }
         }
         if (lineLengthChars > 0) {
-            Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { lineWidth, lineHeight }, {.length = lineLengthChars, .chars = &textElementData->text.chars[lineStartOffset] } });
-            textElementData->wrappedLines.length++;
+            Clay__AddWrappedTextLine(lines, maxLines, &lineCount, CLAY__INIT(Clay__WrappedTextLine) { { lineWidth, lineHeight }, {.length = lineLengthChars, .chars = &textElementData->text.chars[lineStartOffset] } });
+        }
+        if (lines) {
+            containerElement->dimensions.height = lineHeight * (float)CLAY__MIN(lineCount, maxLines);
+            textElementData->storeWrappedLines = lineCount <= maxLines;
+        }
+    }
+    return lineCount;
+}
+
+typedef struct {
+    Clay_Context *context;
+    bool writeLines;
+} Clay__WrapTextJobData;
+
+// Job run through the user's parallelForFunction: first counts each text element's lines, then fills its assigned slice
+void Clay__WrapTextJob(int32_t textElementIndex, void *jobData) {
+    Clay__WrapTextJobData *data = (Clay__WrapTextJobData *)jobData;
+    Clay__TextElementData *textElementData = &data->context->textElementData.internalArray[textElementIndex];
+    if (data->writeLines) {
+        Clay__WrapTextElement(data->context, textElementData, textElementData->wrappedLines.internalArray, textElementData->wrappedLines.length);
+    } else {
+        textElementData->wrappedLines.length = Clay__WrapTextElement(data->context, textElementData, NULL, 0);
+    }
+}
+
+// Copies freshly wrapped lines into the measure text cache, so the next frame can reuse them if the container's width is unchanged.
+// Runs serially after wrapping, because several text elements can share one cache item.
+void Clay__StoreWrappedLines(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    for (int32_t textElementIndex = 0; textElementIndex < context->textElementData.length; ++textElementIndex) {
+        Clay__TextElementData *textElementData = &context->textElementData.internalArray[textElementIndex];
+        Clay__MeasureTextCacheItem *measureTextCacheItem = textElementData->measureTextCacheItem;
+        if (!textElementData->storeWrappedLines || measureTextCacheItem == &Clay__MeasureTextCacheItem_DEFAULT || textElementData->wrappedLines.length > measureTextCacheItem->measuredWordsCount) {
+            continue;
+        }
+        for (int32_t i = 0; i < textElementData->wrappedLines.length; ++i) {
+            Clay__WrappedTextLine *line = &textElementData->wrappedLines.internalArray[i];
+            context->wrappedLinesCache.internalArray[measureTextCacheItem->measuredWordsStartIndex + i] = CLAY__INIT(Clay__MeasuredWord) { .startOffset = (int32_t)(line->line.chars - textElementData->text.chars), .length = line->line.length, .width = line->dimensions.width };
+        }
+        measureTextCacheItem->wrappedLinesCount = textElementData->wrappedLines.length;
+        measureTextCacheItem->wrappedWidth = context->layoutElements.internalArray[textElementData->elementIndex].dimensions.width;
+    }
+}
+
+// Records, for every element, how far its subtree can draw outside of its bounding box and whether a floating element attaches inside it.
+// An offscreen subtree with neither can't affect anything on screen, so the final layout doesn't position it or generate its render commands.
+// Layout elements are stored in declaration order, so walking them backwards visits every element's children before the element itself.
+void Clay__CalculateSubtreeCullingData(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+        Clay_LayoutElementHashMapItem *parentItem = Clay__GetHashMapItem(context->layoutElementTreeRoots.internalArray[rootIndex].parentId);
+        if (parentItem != &Clay_LayoutElementHashMapItem_DEFAULT && parentItem->generation == context->generation + 1) {
+            parentItem->layoutElement->floatingAttachTargetInSubtree = true;
+        }
+    }
+    for (int32_t elementIndex = context->layoutElements.length - 1; elementIndex >= 0; --elementIndex) {
+        Clay_LayoutElement *element = &context->layoutElements.internalArray[elementIndex];
+        if (Clay__ElementHasConfig(element, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+            // Lines can be wider than the element when a single word doesn't fit, and a custom line height offsets them vertically
+            Clay__TextElementData *textElementData = element->childrenOrTextContent.textElementData;
+            Clay_TextElementConfig *textConfig = Clay__FindElementConfigWithType(element, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig;
+            float overflow = textConfig->lineHeight > 0 ? CLAY__MAX((float)textConfig->lineHeight - textElementData->preferredDimensions.height, textElementData->preferredDimensions.height - (float)textConfig->lineHeight) : 0;
+            for (int32_t lineIndex = 0; lineIndex < textElementData->wrappedLines.length; ++lineIndex) {
+                overflow = CLAY__MAX(overflow, textElementData->wrappedLines.internalArray[lineIndex].dimensions.width - element->dimensions.width);
+            }
+            element->subtreeOverflow = overflow;
+            continue;
+        }
+        Clay_LayoutConfig *layoutConfig = element->layoutConfig;
+        bool leftToRight = layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT;
+        float contentAlongAxis = (float)(CLAY__MAX(element->childrenOrTextContent.children.length - 1, 0) * layoutConfig->childGap);
+        float contentAcrossAxis = 0;
+        float childOverflow = 0;
+        for (int32_t i = 0; i < element->childrenOrTextContent.children.length; ++i) {
+            Clay_LayoutElement *childElement = &context->layoutElements.internalArray[element->childrenOrTextContent.children.elements[i]];
+            contentAlongAxis += leftToRight ? childElement->dimensions.width : childElement->dimensions.height;
+            contentAcrossAxis = CLAY__MAX(contentAcrossAxis, leftToRight ? childElement->dimensions.height : childElement->dimensions.width);
+            childOverflow = CLAY__MAX(childOverflow, childElement->subtreeOverflow);
+            element->floatingAttachTargetInSubtree |= childElement->floatingAttachTargetInSubtree;
+        }
+        if (Clay__ElementHasConfig(element, CLAY__ELEMENT_CONFIG_TYPE_SCROLL)) {
+            // Everything inside a scroll container is clipped to it
+            element->subtreeOverflow = 0;
+            continue;
+        }
+        float paddingX = (float)(layoutConfig->padding.left + layoutConfig->padding.right);
+        float paddingY = (float)(layoutConfig->padding.top + layoutConfig->padding.bottom);
+        // However the children are aligned, they can't stick out further than the amount their content exceeds the element
+        float layoutOverflow = CLAY__MAX(
+            (leftToRight ? contentAlongAxis : contentAcrossAxis) + paddingX - element->dimensions.width,
+            (leftToRight ? contentAcrossAxis : contentAlongAxis) + paddingY - element->dimensions.height);
+        if (layoutOverflow > 0 && Clay__ElementHasConfig(element, CLAY__ELEMENT_CONFIG_TYPE_BORDER)) {
+            layoutOverflow += Clay__FindElementConfigWithType(element, CLAY__ELEMENT_CONFIG_TYPE_BORDER).borderElementConfig->width.betweenChildren;
+        }
+        element->subtreeOverflow = CLAY__MAX(layoutOverflow, 0) + childOverflow;
+    }
+}
+
+void Clay__CalculateFinalLayout(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    // Calculate sizing along the X axis
+    Clay__SizeContainersAlongAxis(true);
+
+    // Wrap text
+    int32_t wrappedTextLinesCapacity = context->wrappedTextLines.capacity - context->wrappedTextLines.length;
+    int32_t wrappedTextLinesRequired = 0;
+    if (context->parallelForFunction && context->textElementData.length > 1) {
+        // Count every element's lines in parallel, give each element its own slice of wrappedTextLines in element order,
+        // then fill the slices in parallel. The result is identical to wrapping serially.
+        Clay__WrapTextJobData jobData = { .context = context };
+        context->parallelForFunction(Clay__WrapTextJob, context->textElementData.length, &jobData, context->parallelForUserData);
+        for (int32_t textElementIndex = 0; textElementIndex < context->textElementData.length; ++textElementIndex) {
+            Clay__TextElementData *textElementData = &context->textElementData.internalArray[textElementIndex];
+            int32_t lineCount = CLAY__MIN(textElementData->wrappedLines.length, CLAY__MAX(wrappedTextLinesCapacity - wrappedTextLinesRequired, 0));
+            wrappedTextLinesRequired += textElementData->wrappedLines.length;
+            textElementData->wrappedLines = CLAY__INIT(Clay__WrappedTextLineArraySlice) { .length = lineCount, .internalArray = &context->wrappedTextLines.internalArray[context->wrappedTextLines.length] };
+            context->wrappedTextLines.length += lineCount;
+        }
+        jobData.writeLines = true;
+        context->parallelForFunction(Clay__WrapTextJob, context->textElementData.length, &jobData, context->parallelForUserData);
+    } else {
+        for (int32_t textElementIndex = 0; textElementIndex < context->textElementData.length; ++textElementIndex) {
+            Clay__TextElementData *textElementData = &context->textElementData.internalArray[textElementIndex];
+            int32_t maxLines = CLAY__MAX(wrappedTextLinesCapacity - wrappedTextLinesRequired, 0);
+            int32_t lineCount = Clay__WrapTextElement(context, textElementData, &context->wrappedTextLines.internalArray[context->wrappedTextLines.length], maxLines);
+            wrappedTextLinesRequired += lineCount;
+            textElementData->wrappedLines = CLAY__INIT(Clay__WrappedTextLineArraySlice) { .length = CLAY__MIN(lineCount, maxLines), .internalArray = &context->wrappedTextLines.internalArray[context->wrappedTextLines.length] };
+            context->wrappedTextLines.length += textElementData->wrappedLines.length;
+        }
+    }
+    if (wrappedTextLinesRequired > wrappedTextLinesCapacity) {
+        // Wrapped lines share the per element capacity, so a reduced adaptive capacity drops the frame like any other adaptive array
+        if (Clay__EphemeralCapacityReduced(context)) {
+            context->booleanWarnings.ephemeralCapacityExceeded = true;
+        } else {
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
+                .errorText = CLAY_STRING("Clay ran out of capacity for wrapped lines of text, and the lines past it were dropped. Each wrapped line uses one element of capacity. Try using Clay_SetMaxElementCount() with a higher value, then Clay_ResizeContext() to apply it between frames."),
+                .userData = context->errorHandler.userData });
         }
-        containerElement->dimensions.height = lineHeight * (float)textElementData->wrappedLines.length;
     }
+    Clay__StoreWrappedLines();
 
     // Scale vertical image heights according to aspect ratio
     for (int32_t i = 0; i < context->imageElementPointers.length; ++i) {
@@ -2368,22 +3348,19 @@ void Clay__CalculateFinalLayout(void) {
     // Calculate sizing along the Y axis
     Clay__SizeContainersAlongAxis(false);
 
-    // Sort tree roots by z-index
-    int32_t sortMax = context->layoutElementTreeRoots.length - 1;
-    while (sortMax > 0) { // todo dumb bubble sort
-        for (int32_t i = 0; i < sortMax; ++i) {
-            Clay__LayoutElementTreeRoot current = *Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, i);
-            Clay__LayoutElementTreeRoot next = *Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, i + 1);
-            if (next.zIndex < current.zIndex) {
-                Clay__LayoutElementTreeRootArray_Set(&context->layoutElementTreeRoots, i, next);
-                Clay__LayoutElementTreeRootArray_Set(&context->layoutElementTreeRoots, i + 1, current);
-            }
-        }
-        sortMax--;
-    }
+    Clay__SortLayoutElementTreeRoots();
+
+    Clay__CalculateSubtreeCullingData();
 
     // Calculate final positions and generate render commands
     context->renderCommands.length = 0;
+    context->layoutVersion++;
+    if (Clay__RetainedLayoutActive(context) && (context->layoutDimensions.width != context->retainedLayoutDimensions.width || context->layoutDimensions.height != context->retainedLayoutDimensions.height || context->disableCulling != context->retainedDisableCulling)) {
+        // Culling depends on the layout dimensions, so no previous render commands can be reused
+        Clay__InvalidateRetainedLayout();
+        context->retainedLayoutDimensions = context->layoutDimensions;
+        context->retainedDisableCulling = context->disableCulling;
+    }
     dfsBuffer.length = 0;
     for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
         dfsBuffer.length = 0;
@@ -2446,26 +3423,28 @@ void Clay__CalculateFinalLayout(void) {
             targetAttachPosition.y += config->offset.y;
             rootPosition = targetAttachPosition;
         }
+        Clay_BoundingBox rootCullBoundingBox = { 0, 0, context->layoutDimensions.width, context->layoutDimensions.height };
         if (root->clipElementId) {
             Clay_LayoutElementHashMapItem *clipHashMapItem = Clay__GetHashMapItem(root->clipElementId);
             if (clipHashMapItem) {
                 // Floating elements that are attached to scrolling contents won't be correctly positioned if external scroll handling is enabled, fix here
                 if (context->externalScrollHandlingEnabled) {
                     Clay_ScrollElementConfig *scrollConfig = Clay__FindElementConfigWithType(clipHashMapItem->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig;
-                    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
-                        Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-                        if (mapping->layoutElement == clipHashMapItem->layoutElement) {
-                            root->pointerOffset = mapping->scrollPosition;
-                            if (scrollConfig->horizontal) {
-                                rootPosition.x += mapping->scrollPosition.x;
-                            }
-                            if (scrollConfig->vertical) {
-                                rootPosition.y += mapping->scrollPosition.y;
-                            }
-                            break;
+                    Clay__ScrollContainerDataInternal *mapping = Clay__GetScrollContainerData(root->clipElementId);
+                    if (mapping) {
+                        root->pointerOffset = mapping->scrollPosition;
+                        if (scrollConfig->horizontal) {
+                            rootPosition.x += mapping->scrollPosition.x;
+                        }
+                        if (scrollConfig->vertical) {
+                            rootPosition.y += mapping->scrollPosition.y;
                         }
                     }
                 }
+                // With external scroll handling the renderer moves the contents after layout, so only the window can be culled against
+                if (!context->externalScrollHandlingEnabled) {
+                    rootCullBoundingBox = Clay__IntersectBoundingBoxes(rootCullBoundingBox, clipHashMapItem->boundingBox);
+                }
                 Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
                     .boundingBox = clipHashMapItem->boundingBox,
                     .userData = 0,
@@ -2475,7 +3454,7 @@ void Clay__CalculateFinalLayout(void) {
                 });
             }
         }
-        Clay__LayoutElementTreeNodeArray_Add(&dfsBuffer, CLAY__INIT(Clay__LayoutElementTreeNode) { .layoutElement = rootElement, .position = rootPosition, .nextChildOffset = { .x = (float)rootElement->layoutConfig->padding.left, .y = (float)rootElement->layoutConfig->padding.top } });
+        Clay__LayoutElementTreeNodeArray_Add(&dfsBuffer, CLAY__INIT(Clay__LayoutElementTreeNode) { .layoutElement = rootElement, .position = rootPosition, .nextChildOffset = { .x = (float)rootElement->layoutConfig->padding.left, .y = (float)rootElement->layoutConfig->padding.top }, .cullBoundingBox = rootCullBoundingBox, .parentNodeIndex = -1 });
 
         context->treeNodeVisited.internalArray[0] = false;
         while (dfsBuffer.length > 0) {
@@ -2483,6 +3462,7 @@ void Clay__CalculateFinalLayout(void) {
             Clay_LayoutElement *currentElement = currentElementTreeNode->layoutElement;
             Clay_LayoutConfig *layoutConfig = currentElement->layoutConfig;
             Clay_Vector2 scrollOffset = CLAY__DEFAULT_STRUCT;
+            bool cullChildren = false;
 
             // This will only be run a single time for each element in downwards DFS order
             if (!context->treeNodeVisited.internalArray[dfsBuffer.length - 1]) {
@@ -2503,27 +3483,40 @@ void Clay__CalculateFinalLayout(void) {
                 if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL)) {
                     Clay_ScrollElementConfig *scrollConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig;
 
-                    // This linear scan could theoretically be slow under very strange conditions, but I can't imagine a real UI with more than a few 10's of scroll containers
-                    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
-                        Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-                        if (mapping->layoutElement == currentElement) {
-                            scrollContainerData = mapping;
-                            mapping->boundingBox = currentElementBoundingBox;
-                            if (scrollConfig->horizontal) {
-                                scrollOffset.x = mapping->scrollPosition.x;
-                            }
-                            if (scrollConfig->vertical) {
-                                scrollOffset.y = mapping->scrollPosition.y;
-                            }
-                            if (context->externalScrollHandlingEnabled) {
-                                scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
-                            }
-                            break;
+                    scrollContainerData = Clay__GetScrollContainerData(currentElement->id);
+                    if (scrollContainerData) {
+                        scrollContainerData->boundingBox = currentElementBoundingBox;
+                        if (scrollConfig->horizontal) {
+                            scrollOffset.x = scrollContainerData->scrollPosition.x;
                         }
+                        if (scrollConfig->vertical) {
+                            scrollOffset.y = scrollContainerData->scrollPosition.y;
+                        }
+                        if (context->externalScrollHandlingEnabled) {
+                            scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
+                        }
+                    }
+                    // Everything this element draws, including its own rectangle and border, is inside its scissor
+                    if (!context->externalScrollHandlingEnabled) {
+                        currentElementTreeNode->cullBoundingBox = Clay__IntersectBoundingBoxes(currentElementTreeNode->cullBoundingBox, currentElementBoundingBox);
                     }
                 }
+                Clay_BoundingBox cullBoundingBox = currentElementTreeNode->cullBoundingBox;
 
                 Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(currentElement->id);
+                currentElementTreeNode->hashMapItem = hashMapItem;
+                if (Clay__RetainedLayoutActive(context)) {
+                    if (Clay__ReuseRetainedRenderCommands(hashMapItem, currentElement, currentElementBoundingBox, cullBoundingBox, root->zIndex)) {
+                        if (currentElementTreeNode->parentNodeIndex >= 0) {
+                            Clay__LayoutElementTreeNode *parentNode = &dfsBuffer.internalArray[currentElementTreeNode->parentNodeIndex];
+                            parentNode->subtreeBoundingBox = Clay__UnionBoundingBoxes(parentNode->subtreeBoundingBox, hashMapItem->subtreeBoundingBox);
+                        }
+                        dfsBuffer.length--;
+                        continue;
+                    }
+                    hashMapItem->retained.renderCommandsStart = context->renderCommands.length;
+                }
+                currentElementTreeNode->subtreeBoundingBox = currentElementBoundingBox;
                 if (hashMapItem) {
                     hashMapItem->boundingBox = currentElementBoundingBox;
                     if (hashMapItem->idAlias) {
@@ -2534,25 +3527,6 @@ void Clay__CalculateFinalLayout(void) {
                     }
                 }
 
-                int32_t sortedConfigIndexes[20];
-                for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
-                    sortedConfigIndexes[elementConfigIndex] = elementConfigIndex;
-                }
-                sortMax = currentElement->elementConfigs.length - 1;
-                while (sortMax > 0) { // todo dumb bubble sort
-                    for (int32_t i = 0; i < sortMax; ++i) {
-                        int32_t current = sortedConfigIndexes[i];
-                        int32_t next = sortedConfigIndexes[i + 1];
-                        Clay__ElementConfigType currentType = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, current)->type;
-                        Clay__ElementConfigType nextType = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, next)->type;
-                        if (nextType == CLAY__ELEMENT_CONFIG_TYPE_SCROLL || currentType == CLAY__ELEMENT_CONFIG_TYPE_BORDER) {
-                            sortedConfigIndexes[i] = next;
-                            sortedConfigIndexes[i + 1] = current;
-                        }
-                    }
-                    sortMax--;
-                }
-
                 bool emitRectangle = false;
                 // Create the render commands for this element
                 Clay_SharedElementConfig *sharedConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED).sharedElementConfig;
@@ -2563,24 +3537,31 @@ void Clay__CalculateFinalLayout(void) {
                     emitRectangle = false;
                     sharedConfig = &Clay_SharedElementConfig_DEFAULT;
                 }
-                for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
-                    Clay_ElementConfig *elementConfig = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, sortedConfigIndexes[elementConfigIndex]);
+                // Culling - Don't bother to generate render commands for elements entirely outside the screen or scrolled out of view - this won't stop their children from being rendered if they overflow
+                bool offscreen = Clay__ElementIsOffscreen(&currentElementBoundingBox, &cullBoundingBox);
+                // If nothing in the subtree can reach the screen and no floating element needs its position, don't visit the descendants at all
+                if (offscreen && !currentElement->floatingAttachTargetInSubtree) {
+                    float overflow = currentElement->subtreeOverflow;
+                    Clay_BoundingBox subtreeBoundingBox = { currentElementBoundingBox.x - overflow, currentElementBoundingBox.y - overflow, currentElementBoundingBox.width + overflow * 2, currentElementBoundingBox.height + overflow * 2 };
+                    cullChildren = Clay__ElementIsOffscreen(&subtreeBoundingBox, &cullBoundingBox);
+                }
+                hashMapItem->childrenCulled = cullChildren;
+                // Only these config types generate render commands on the way down the tree. The scissor must start before any of the element's own
+                // render commands, while borders are generated on the way back up, after the element's children.
+                static const Clay__ElementConfigType renderCommandConfigTypes[] = { CLAY__ELEMENT_CONFIG_TYPE_SCROLL, CLAY__ELEMENT_CONFIG_TYPE_IMAGE, CLAY__ELEMENT_CONFIG_TYPE_CUSTOM, CLAY__ELEMENT_CONFIG_TYPE_TEXT };
+                for (int32_t typeIndex = 0; typeIndex < 4; ++typeIndex) {
+                    if (!Clay__ElementHasConfig(currentElement, renderCommandConfigTypes[typeIndex])) {
+                        continue;
+                    }
+                    Clay_ElementConfig *elementConfig = &currentElement->elementConfigs.internalArray[currentElement->elementConfigIndexes[renderCommandConfigTypes[typeIndex]]];
                     Clay_RenderCommand renderCommand = {
                         .boundingBox = currentElementBoundingBox,
                         .userData = sharedConfig->userData,
                         .id = currentElement->id,
                     };
 
-                    bool offscreen = Clay__ElementIsOffscreen(&currentElementBoundingBox);
-                    // Culling - Don't bother to generate render commands for rectangles entirely outside the screen - this won't stop their children from being rendered if they overflow
                     bool shouldRender = !offscreen;
                     switch (elementConfig->type) {
-                        case CLAY__ELEMENT_CONFIG_TYPE_FLOATING:
-                        case CLAY__ELEMENT_CONFIG_TYPE_SHARED:
-                        case CLAY__ELEMENT_CONFIG_TYPE_BORDER: {
-                            shouldRender = false;
-                            break;
-                        }
                         case CLAY__ELEMENT_CONFIG_TYPE_SCROLL: {
                             renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_START;
                             renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
@@ -2617,6 +3598,17 @@ void Clay__CalculateFinalLayout(void) {
                             float yPosition = lineHeightOffset;
                             for (int32_t lineIndex = 0; lineIndex < currentElement->childrenOrTextContent.textElementData->wrappedLines.length; ++lineIndex) {
                                 Clay__WrappedTextLine *wrappedLine = Clay__WrappedTextLineArraySlice_Get(&currentElement->childrenOrTextContent.textElementData->wrappedLines, lineIndex);
+                                if (!context->disableCulling) {
+                                    float lineY = currentElementBoundingBox.y + yPosition;
+                                    if (lineY > cullBoundingBox.y + cullBoundingBox.height) {
+                                        break;
+                                    }
+                                    // Lines scrolled up out of view
+                                    if (lineY + wrappedLine->dimensions.height < cullBoundingBox.y) {
+                                        yPosition += finalLineHeight;
+                                        continue;
+                                    }
+                                }
                                 if (wrappedLine->line.length == 0) {
                                     yPosition += finalLineHeight;
                                     continue;
@@ -2644,10 +3636,6 @@ void Clay__CalculateFinalLayout(void) {
                                     .commandType = CLAY_RENDER_COMMAND_TYPE_TEXT,
                                 });
                                 yPosition += finalLineHeight;
-
-                                if (!context->disableCulling && (currentElementBoundingBox.y + yPosition > context->layoutDimensions.height)) {
-                                    break;
-                                }
                             }
                             break;
                         }
@@ -2675,7 +3663,7 @@ void Clay__CalculateFinalLayout(void) {
                     }
                 }
 
-                if (emitRectangle) {
+                if (emitRectangle && !offscreen) {
                     Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
                         .boundingBox = currentElementBoundingBox,
                         .renderData = { .rectangle = {
@@ -2733,25 +3721,22 @@ void Clay__CalculateFinalLayout(void) {
                 Clay_ScrollElementConfig *scrollConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig;
                 if (scrollConfig) {
                     closeScrollElement = true;
-                    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
-                        Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-                        if (mapping->layoutElement == currentElement) {
-                            if (scrollConfig->horizontal) { scrollOffset.x = mapping->scrollPosition.x; }
-                            if (scrollConfig->vertical) { scrollOffset.y = mapping->scrollPosition.y; }
-                            if (context->externalScrollHandlingEnabled) {
-                                scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
-                            }
-                            break;
+                    Clay__ScrollContainerDataInternal *mapping = Clay__GetScrollContainerData(currentElement->id);
+                    if (mapping) {
+                        if (scrollConfig->horizontal) { scrollOffset.x = mapping->scrollPosition.x; }
+                        if (scrollConfig->vertical) { scrollOffset.y = mapping->scrollPosition.y; }
+                        if (context->externalScrollHandlingEnabled) {
+                            scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
                         }
                     }
                 }
 
                 if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER)) {
-                    Clay_LayoutElementHashMapItem *currentElementData = Clay__GetHashMapItem(currentElement->id);
+                    Clay_LayoutElementHashMapItem *currentElementData = currentElementTreeNode->hashMapItem;
                     Clay_BoundingBox currentElementBoundingBox = currentElementData->boundingBox;
 
                     // Culling - Don't bother to generate render commands for rectangles entirely outside the screen - this won't stop their children from being rendered if they overflow
-                    if (!Clay__ElementIsOffscreen(&currentElementBoundingBox)) {
+                    if (!Clay__ElementIsOffscreen(&currentElementBoundingBox, &currentElementTreeNode->cullBoundingBox)) {
                         Clay_SharedElementConfig *sharedConfig = Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED) ? Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED).sharedElementConfig : &Clay_SharedElementConfig_DEFAULT;
                         Clay_BorderElementConfig *borderConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER).borderElementConfig;
                         Clay_RenderCommand renderCommand = {
@@ -2805,20 +3790,44 @@ void Clay__CalculateFinalLayout(void) {
                         }
                     }
                 }
-                // This exists because the scissor needs to end _after_ borders between elements
-                if (closeScrollElement) {
+                // This exists because the scissor needs to end _after_ borders between elements. Culled scroll containers never started theirs.
+                if (closeScrollElement && !Clay__ElementIsOffscreen(&currentElementTreeNode->hashMapItem->boundingBox, &currentElementTreeNode->cullBoundingBox)) {
                     Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                        .id = Clay__HashNumber(currentElement->id, rootElement->childrenOrTextContent.children.length + 11).id,
+                        .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length + 11).id,
                         .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_END,
                     });
                 }
 
+                Clay_LayoutElementHashMapItem *hashMapItem = currentElementTreeNode->hashMapItem;
+                // Elements with duplicate IDs share a hash map item, so their subtrees are combined
+                if (hashMapItem->subtreeBoundingBoxGeneration == context->generation) {
+                    hashMapItem->subtreeBoundingBox = Clay__UnionBoundingBoxes(hashMapItem->subtreeBoundingBox, currentElementTreeNode->subtreeBoundingBox);
+                } else {
+                    hashMapItem->subtreeBoundingBox = currentElementTreeNode->subtreeBoundingBox;
+                    hashMapItem->subtreeBoundingBoxGeneration = context->generation;
+                }
+                if (currentElementTreeNode->parentNodeIndex >= 0) {
+                    Clay__LayoutElementTreeNode *parentNode = &dfsBuffer.internalArray[currentElementTreeNode->parentNodeIndex];
+                    parentNode->subtreeBoundingBox = Clay__UnionBoundingBoxes(parentNode->subtreeBoundingBox, currentElementTreeNode->subtreeBoundingBox);
+                }
+
+                if (Clay__RetainedLayoutActive(context)) {
+                    if (hashMapItem->layoutElement == currentElement) {
+                        hashMapItem->retained.declarationHash = currentElement->declarationHash;
+                        hashMapItem->retained.renderCommandsVersion = context->retainedRenderCommandsVersion + 1;
+                        hashMapItem->retained.renderCommandsLength = context->renderCommands.length - hashMapItem->retained.renderCommandsStart;
+                        hashMapItem->retained.zIndex = root->zIndex;
+                        hashMapItem->retained.cullBoundingBox = currentElementTreeNode->cullBoundingBox;
+                    }
+                }
+
                 dfsBuffer.length--;
                 continue;
             }
 
             // Add children to the DFS buffer
-            if (!Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+            if (!Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) && !cullChildren) {
+                int32_t parentNodeIndex = (int32_t)dfsBuffer.length - 1;
                 dfsBuffer.length += currentElement->childrenOrTextContent.children.length;
                 for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
                     Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
@@ -2852,6 +3861,8 @@ void Clay__CalculateFinalLayout(void) {
                         .layoutElement = childElement,
                         .position = { childPosition.x, childPosition.y },
                         .nextChildOffset = { .x = (float)childElement->layoutConfig->padding.left, .y = (float)childElement->layoutConfig->padding.top },
+                        .cullBoundingBox = currentElementTreeNode->cullBoundingBox,
+                        .parentNodeIndex = parentNodeIndex,
                     };
                     context->treeNodeVisited.internalArray[newNodeIndex] = false;
 
@@ -2949,7 +3960,8 @@ Clay__RenderDebugLayoutData Clay__RenderDebugLayoutElementsList(int32_t initialR
 
             context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = true;
             Clay_LayoutElementHashMapItem *currentElementData = Clay__GetHashMapItem(currentElement->id);
-            bool offscreen = Clay__ElementIsOffscreen(&currentElementData->boundingBox);
+            Clay_BoundingBox layoutBoundingBox = { 0, 0, context->layoutDimensions.width, context->layoutDimensions.height };
+            bool offscreen = Clay__ElementIsOffscreen(&currentElementData->boundingBox, &layoutBoundingBox);
             if (context->debugSelectedElementId == currentElement->id) {
                 layoutData.selectedElementRowIndex = layoutData.rowCount;
             }
@@ -3163,15 +4175,12 @@ void Clay__RenderDebugView(void) {
     Clay_ElementId scrollId = Clay__HashString(CLAY_STRING("Clay__DebugViewOuterScrollPane"), 0, 0);
     float scrollYOffset = 0;
     bool pointerInDebugView = context->pointerInfo.position.y < context->layoutDimensions.height - 300;
-    for (int32_t i = 0; i < context->scrollContainerDatas.length; ++i) {
-        Clay__ScrollContainerDataInternal *scrollContainerData = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-        if (scrollContainerData->elementId == scrollId.id) {
-            if (!context->externalScrollHandlingEnabled) {
-                scrollYOffset = scrollContainerData->scrollPosition.y;
-            } else {
-                pointerInDebugView = context->pointerInfo.position.y + scrollContainerData->scrollPosition.y < context->layoutDimensions.height - 300;
-            }
-            break;
+    Clay__ScrollContainerDataInternal *scrollContainerData = Clay__GetScrollContainerData(scrollId.id);
+    if (scrollContainerData) {
+        if (!context->externalScrollHandlingEnabled) {
+            scrollYOffset = scrollContainerData->scrollPosition.y;
+        } else {
+            pointerInDebugView = context->pointerInfo.position.y + scrollContainerData->scrollPosition.y < context->layoutDimensions.height - 300;
         }
     }
     int32_t highlightedRow = pointerInDebugView
@@ -3539,12 +4548,16 @@ bool Clay__Array_RangeCheck(int32_t index, int32_t length)
     return false;
 }
 
-bool Clay__Array_AddCapacityCheck(int32_t length, int32_t capacity)
+bool Clay__Array_AddCapacityCheck(const void *internalArray, int32_t length, int32_t capacity)
 {
     if (length < capacity) {
         return true;
     }
     Clay_Context* context = Clay_GetCurrentContext();
+    if (Clay__IsReducedAdaptiveArray(context, internalArray)) {
+        context->booleanWarnings.ephemeralCapacityExceeded = true;
+        return false;
+    }
     context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
         .errorType = CLAY_ERROR_TYPE_INTERNAL_ERROR,
         .errorText = CLAY_STRING("Clay attempted to make an out of bounds array access. This is an internal error and is likely a bug."),
@@ -3559,6 +4572,7 @@ uint32_t Clay_MinMemorySize(void) {
     Clay_Context fakeContext = {
         .maxElementCount = Clay__defaultMaxElementCount,
         .maxMeasureTextCacheWordCount = Clay__defaultMaxMeasureTextWordCacheCount,
+        .maxScrollContainerCount = Clay__defaultMaxScrollContainerCount,
         .internalArena = {
             .capacity = SIZE_MAX,
             .memory = NULL,
@@ -3567,7 +4581,11 @@ uint32_t Clay_MinMemorySize(void) {
     Clay_Context* currentContext = Clay_GetCurrentContext();
     if (currentContext) {
         fakeContext.maxElementCount = currentContext->maxElementCount;
-        fakeContext.maxMeasureTextCacheWordCount = currentContext->maxElementCount;
+        fakeContext.maxMeasureTextCacheWordCount = currentContext->maxMeasureTextCacheWordCount;
+        fakeContext.maxScrollContainerCount = currentContext->maxScrollContainerCount;
+        fakeContext.retainedLayoutEnabled = currentContext->retainedLayoutEnabled;
+        fakeContext.renderCommandDiffEnabled = currentContext->renderCommandDiffEnabled;
+        fakeContext.packedRenderCommandsEnabled = currentContext->packedRenderCommandsEnabled;
     }
     // Reserve space in the arena for the context, important for calculating min memory size correctly
     Clay__Context_Allocate_Arena(&fakeContext.internalArena);
@@ -3588,14 +4606,20 @@ Clay_Arena Clay_CreateArenaWithCapacityAndMemory(uint32_t capacity, void *memory
 #ifndef CLAY_WASM
 void Clay_SetMeasureTextFunction(Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData), void *userData) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay__MeasureText = measureTextFunction;
+    context->measureTextFunction = measureTextFunction;
     context->measureTextUserData = userData;
+    Clay__InvalidateRetainedLayout();
 }
 void Clay_SetQueryScrollOffsetFunction(Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData), void *userData) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay__QueryScrollOffset = queryScrollOffsetFunction;
+    context->queryScrollOffsetFunction = queryScrollOffsetFunction;
     context->queryScrollOffsetUserData = userData;
 }
+void Clay_SetParallelForFunction(void (*parallelForFunction)(void (*job)(int32_t index, void *jobData), int32_t jobCount, void *jobData, void *userData), void *userData) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->parallelForFunction = parallelForFunction;
+    context->parallelForUserData = userData;
+}
 #endif
 
 CLAY_WASM_EXPORT("Clay_SetLayoutDimensions")
@@ -3603,6 +4627,23 @@ void Clay_SetLayoutDimensions(Clay_Dimensions dimensions) {
     Clay_GetCurrentContext()->layoutDimensions = dimensions;
 }
 
+void Clay__UpdatePointerDownState(bool isPointerDown) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (isPointerDown) {
+        if (context->pointerInfo.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME) {
+            context->pointerInfo.state = CLAY_POINTER_DATA_PRESSED;
+        } else if (context->pointerInfo.state != CLAY_POINTER_DATA_PRESSED) {
+            context->pointerInfo.state = CLAY_POINTER_DATA_PRESSED_THIS_FRAME;
+        }
+    } else {
+        if (context->pointerInfo.state == CLAY_POINTER_DATA_RELEASED_THIS_FRAME) {
+            context->pointerInfo.state = CLAY_POINTER_DATA_RELEASED;
+        } else if (context->pointerInfo.state != CLAY_POINTER_DATA_RELEASED)  {
+            context->pointerInfo.state = CLAY_POINTER_DATA_RELEASED_THIS_FRAME;
+        }
+    }
+}
+
 CLAY_WASM_EXPORT("Clay_SetPointerState")
 void Clay_SetPointerState(Clay_Vector2 position, bool isPointerDown) {
     Clay_Context* context = Clay_GetCurrentContext();
@@ -3610,6 +4651,22 @@ void Clay_SetPointerState(Clay_Vector2 position, bool isPointerDown) {
         return;
     }
     context->pointerInfo.position = position;
+    if (!context->externalScrollHandlingEnabled && context->pointerOverLayoutVersion == context->layoutVersion && context->pointerOverPosition.x == position.x && context->pointerOverPosition.y == position.y) {
+        // Neither the pointer nor the layout have moved since the last hit test, so the previous result is still valid and only the hover callbacks need to run again
+        for (int32_t i = 0; i < context->pointerOverIds.length; ++i) {
+            Clay_LayoutElementHashMapItem *mapItem = Clay__GetHashMapItem(context->pointerOverIds.internalArray[i].id);
+            if (mapItem->onHoverFunction) {
+                mapItem->onHoverFunction(mapItem->elementId, context->pointerInfo, mapItem->hoverFunctionUserData);
+            }
+            if (mapItem->idAlias != 0) {
+                i++; // Skip the alias, which always directly follows the element
+            }
+        }
+        Clay__UpdatePointerDownState(isPointerDown);
+        return;
+    }
+    context->pointerOverLayoutVersion = context->layoutVersion;
+    context->pointerOverPosition = position;
     context->pointerOverIds.length = 0;
     Clay__int32_tArray dfsBuffer = context->layoutElementChildrenBuffer;
     for (int32_t rootIndex = context->layoutElementTreeRoots.length - 1; rootIndex >= 0; --rootIndex) {
@@ -3625,7 +4682,14 @@ void Clay_SetPointerState(Clay_Vector2 position, bool isPointerDown) {
             }
             context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = true;
             Clay_LayoutElement *currentElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&dfsBuffer, (int)dfsBuffer.length - 1));
-            Clay_LayoutElementHashMapItem *mapItem = Clay__GetHashMapItem(currentElement->id); // TODO think of a way around this, maybe the fact that it's essentially a binary tree limits the cost, but the worst case is not great
+            Clay_LayoutElementHashMapItem *mapItem = Clay__GetHashMapItem(currentElement->id);
+            Clay_BoundingBox subtreeBox = mapItem->subtreeBoundingBox;
+            subtreeBox.x -= root->pointerOffset.x;
+            subtreeBox.y -= root->pointerOffset.y;
+            if (!Clay__PointMayBeInsideRect(position, subtreeBox)) { // Neither this element nor any of its descendants can contain the pointer
+                dfsBuffer.length--;
+                continue;
+            }
             Clay_BoundingBox elementBox = mapItem->boundingBox;
             elementBox.x -= root->pointerOffset.x;
             elementBox.y -= root->pointerOffset.y;
@@ -3641,7 +4705,7 @@ void Clay_SetPointerState(Clay_Vector2 position, bool isPointerDown) {
                         Clay__ElementIdArray_Add(&context->pointerOverIds, CLAY__INIT(Clay_ElementId) { .id = mapItem->idAlias });
                     }
                 }
-                if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+                if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) || mapItem->childrenCulled) {
                     dfsBuffer.length--;
                     continue;
                 }
@@ -3661,19 +4725,7 @@ void Clay_SetPointerState(Clay_Vector2 position, bool isPointerDown) {
         }
     }
 
-    if (isPointerDown) {
-        if (context->pointerInfo.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME) {
-            context->pointerInfo.state = CLAY_POINTER_DATA_PRESSED;
-        } else if (context->pointerInfo.state != CLAY_POINTER_DATA_PRESSED) {
-            context->pointerInfo.state = CLAY_POINTER_DATA_PRESSED_THIS_FRAME;
-        }
-    } else {
-        if (context->pointerInfo.state == CLAY_POINTER_DATA_RELEASED_THIS_FRAME) {
-            context->pointerInfo.state = CLAY_POINTER_DATA_RELEASED;
-        } else if (context->pointerInfo.state != CLAY_POINTER_DATA_RELEASED)  {
-            context->pointerInfo.state = CLAY_POINTER_DATA_RELEASED_THIS_FRAME;
-        }
-    }
+    Clay__UpdatePointerDownState(isPointerDown);
 }
 
 CLAY_WASM_EXPORT("Clay_Initialize")
@@ -3685,15 +4737,22 @@ Clay_Context* Clay_Initialize(Clay_Arena arena, Clay_Dimensions layoutDimensions
     *context = CLAY__INIT(Clay_Context) {
         .maxElementCount = oldContext ? oldContext->maxElementCount : Clay__defaultMaxElementCount,
         .maxMeasureTextCacheWordCount = oldContext ? oldContext->maxMeasureTextCacheWordCount : Clay__defaultMaxMeasureTextWordCacheCount,
+        .maxScrollContainerCount = oldContext ? oldContext->maxScrollContainerCount : Clay__defaultMaxScrollContainerCount,
         .errorHandler = errorHandler.errorHandlerFunction ? errorHandler : CLAY__INIT(Clay_ErrorHandler) { Clay__ErrorHandlerFunctionDefault, 0 },
         .layoutDimensions = layoutDimensions,
+        .measureTextFunction = oldContext ? oldContext->measureTextFunction : NULL,
+        .queryScrollOffsetFunction = oldContext ? oldContext->queryScrollOffsetFunction : NULL,
+        .measureTextUserData = oldContext ? oldContext->measureTextUserData : NULL,
+        .queryScrollOffsetUserData = oldContext ? oldContext->queryScrollOffsetUserData : NULL,
+        .parallelForFunction = oldContext ? oldContext->parallelForFunction : NULL,
+        .parallelForUserData = oldContext ? oldContext->parallelForUserData : NULL,
         .internalArena = arena,
     };
     Clay_SetCurrentContext(context);
     Clay__InitializePersistentMemory(context);
     Clay__InitializeEphemeralMemory(context);
     for (int32_t i = 0; i < context->layoutElementsHashMap.capacity; ++i) {
-        context->layoutElementsHashMap.internalArray[i] = -1;
+        context->layoutElementsHashMap.internalArray[i] = CLAY__INIT(Clay__LayoutElementHashMapSlot) { .itemIndex = -1 };
     }
     for (int32_t i = 0; i < context->measureTextHashMap.capacity; ++i) {
         context->measureTextHashMap.internalArray[i] = 0;
@@ -3703,6 +4762,97 @@ Clay_Context* Clay_Initialize(Clay_Arena arena, Clay_Dimensions layoutDimensions
     return context;
 }
 
+void Clay__CopyArrayItems(void *destination, const void *source, int32_t count, size_t itemSize) {
+    char *destinationBytes = (char *)destination;
+    const char *sourceBytes = (const char *)source;
+    for (size_t i = 0; i < (size_t)count * itemSize; ++i) {
+        destinationBytes[i] = sourceBytes[i];
+    }
+}
+
+CLAY_WASM_EXPORT("Clay_ResizeContext")
+Clay_Context* Clay_ResizeContext(Clay_Arena arena) {
+    Clay_Context *oldContext = Clay_GetCurrentContext();
+    Clay_Context *context = Clay__Context_Allocate_Arena(&arena);
+    if (context == NULL) return NULL;
+    *context = *oldContext;
+    context->internalArena = arena;
+    Clay_SetCurrentContext(context);
+    Clay__InitializePersistentMemory(context);
+    Clay__InitializeEphemeralMemory(context);
+
+    // Element hash map - items keep their indexes, so only the slots need rebuilding
+    int32_t itemCount = CLAY__MIN(oldContext->layoutElementsHashMapInternal.length, context->layoutElementsHashMapInternal.capacity - 1);
+    Clay__CopyArrayItems(context->layoutElementsHashMapInternal.internalArray, oldContext->layoutElementsHashMapInternal.internalArray, itemCount, sizeof(Clay_LayoutElementHashMapItem));
+    context->layoutElementsHashMapInternal.length = itemCount;
+    Clay__CopyArrayItems(context->debugElementData.internalArray, oldContext->debugElementData.internalArray, itemCount, sizeof(Clay__DebugElementData));
+    context->debugElementData.length = itemCount;
+    for (int32_t i = 0; i < context->layoutElementsHashMap.capacity; ++i) {
+        context->layoutElementsHashMap.internalArray[i] = CLAY__INIT(Clay__LayoutElementHashMapSlot) { .itemIndex = -1 };
+    }
+    for (int32_t i = 0; i < itemCount; ++i) {
+        Clay_LayoutElementHashMapItem *item = &context->layoutElementsHashMapInternal.internalArray[i];
+        // Layout element pointers only refer to the previous frame, keep them pointing at the same index of the new layout element array
+        item->layoutElement = context->layoutElements.internalArray + CLAY__MIN(item->layoutElement - oldContext->layoutElements.internalArray, context->layoutElements.capacity - 1);
+        item->debugData = context->debugElementData.internalArray + (item->debugData - oldContext->debugElementData.internalArray);
+        Clay__InsertLayoutElementHashMapSlot(CLAY__INIT(Clay__LayoutElementHashMapSlot) { .id = item->elementId.id, .itemIndex = i });
+    }
+
+    // Text measurement cache - if it no longer fits, start again with an empty cache
+    for (int32_t i = 0; i < context->measureTextHashMap.capacity; ++i) {
+        context->measureTextHashMap.internalArray[i] = 0;
+    }
+    context->measureTextHashMapInternal.length = 1; // Reserve the 0 value to mean "no next element"
+    if (oldContext->measureTextHashMapInternal.length <= context->measureTextHashMapInternal.capacity && oldContext->measuredWords.length <= context->measuredWords.capacity) {
+        Clay__CopyArrayItems(context->measureTextHashMapInternal.internalArray, oldContext->measureTextHashMapInternal.internalArray, oldContext->measureTextHashMapInternal.length, sizeof(Clay__MeasureTextCacheItem));
+        context->measureTextHashMapInternal.length = oldContext->measureTextHashMapInternal.length;
+        Clay__CopyArrayItems(context->measureTextHashMapInternalFreeList.internalArray, oldContext->measureTextHashMapInternalFreeList.internalArray, oldContext->measureTextHashMapInternalFreeList.length, sizeof(int32_t));
+        context->measureTextHashMapInternalFreeList.length = oldContext->measureTextHashMapInternalFreeList.length;
+        Clay__CopyArrayItems(context->measuredWords.internalArray, oldContext->measuredWords.internalArray, oldContext->measuredWords.length, sizeof(Clay__MeasuredWord));
+        context->measuredWords.length = oldContext->measuredWords.length;
+        Clay__CopyArrayItems(context->measuredWordRunOwners.internalArray, oldContext->measuredWordRunOwners.internalArray, oldContext->measuredWords.length, sizeof(int32_t));
+        Clay__CopyArrayItems(context->wrappedLinesCache.internalArray, oldContext->wrappedLinesCache.internalArray, oldContext->measuredWords.length, sizeof(Clay__MeasuredWord));
+        // The bucket count depends on the cache size, so relink every chain into the new buckets
+        uint32_t oldBucketCount = oldContext->maxMeasureTextCacheWordCount / 32;
+        uint32_t bucketCount = context->maxMeasureTextCacheWordCount / 32;
+        for (uint32_t oldBucket = 0; oldBucket < oldBucketCount; ++oldBucket) {
+            int32_t itemIndex = oldContext->measureTextHashMap.internalArray[oldBucket];
+            while (itemIndex != 0) {
+                Clay__MeasureTextCacheItem *cacheItem = &context->measureTextHashMapInternal.internalArray[itemIndex];
+                int32_t nextIndex = cacheItem->nextIndex;
+                uint32_t bucket = cacheItem->id % bucketCount;
+                cacheItem->nextIndex = context->measureTextHashMap.internalArray[bucket];
+                context->measureTextHashMap.internalArray[bucket] = itemIndex;
+                itemIndex = nextIndex;
+            }
+        }
+    }
+
+    // Scroll containers - the element pointer is cleared until the container is next declared
+    int32_t scrollContainerCount = CLAY__MIN(oldContext->scrollContainerDatas.length, context->scrollContainerDatas.capacity);
+    Clay__CopyArrayItems(context->scrollContainerDatas.internalArray, oldContext->scrollContainerDatas.internalArray, scrollContainerCount, sizeof(Clay__ScrollContainerDataInternal));
+    context->scrollContainerDatas.length = scrollContainerCount;
+    for (int32_t i = 0; i < scrollContainerCount; ++i) {
+        context->scrollContainerDatas.internalArray[i].layoutElement = CLAY__NULL;
+    }
+
+    int32_t pointerOverCount = CLAY__MIN(oldContext->pointerOverIds.length, context->pointerOverIds.capacity);
+    Clay__CopyArrayItems(context->pointerOverIds.internalArray, oldContext->pointerOverIds.internalArray, pointerOverCount, sizeof(Clay_ElementId));
+    context->pointerOverIds.length = pointerOverCount;
+    // Keep the previous frame's render commands, so that the next render command diff is still relative to what was last drawn
+    if (oldContext->previousRenderCommands.length <= context->previousRenderCommands.capacity) {
+        Clay__CopyArrayItems(context->previousRenderCommands.internalArray, oldContext->previousRenderCommands.internalArray, oldContext->previousRenderCommands.length, sizeof(Clay_RenderCommand));
+        Clay__CopyArrayItems(context->previousRenderCommandTextHashes.internalArray, oldContext->previousRenderCommandTextHashes.internalArray, oldContext->previousRenderCommands.length, sizeof(uint32_t));
+        context->previousRenderCommands.length = oldContext->previousRenderCommands.length;
+    } else {
+        context->previousRenderCommands.length = 0;
+    }
+    // The previous frame's layout tree wasn't moved, so the next hit test has nothing to hit until the next layout
+    context->layoutVersion++;
+    Clay__InvalidateRetainedLayout();
+    return context;
+}
+
 CLAY_WASM_EXPORT("Clay_GetCurrentContext")
 Clay_Context* Clay_GetCurrentContext(void) {
     return Clay__currentContext;
@@ -3723,16 +4873,21 @@ void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_Vector2 scrollDe
     for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
         Clay__ScrollContainerDataInternal *scrollData = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
         if (!scrollData->openThisFrame) {
-            Clay__ScrollContainerDataInternalArray_RemoveSwapback(&context->scrollContainerDatas, i);
+            if (context->booleanWarnings.ephemeralCapacityExceeded) {
+                // The dropped layout may have stopped before declaring this container, so it is only removed once a complete layout omits it.
+                // Its layout element is from an earlier frame, whose slot the dropped layout may have reused.
+                scrollData->layoutElement = CLAY__NULL;
+                continue;
+            }
+            Clay__RemoveScrollContainerData(i);
+            i--; // The last scroll container was swapped into this slot
             continue;
         }
-        scrollData->openThisFrame = false;
-        Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(scrollData->elementId);
-        // Element isn't rendered this frame but scroll offset has been retained
-        if (!hashMapItem) {
-            Clay__ScrollContainerDataInternalArray_RemoveSwapback(&context->scrollContainerDatas, i);
+        // The context was resized, or the layout dropped, since this container was last declared
+        if (!scrollData->layoutElement) {
             continue;
         }
+        scrollData->openThisFrame = false;
 
         // Touch / click is released
         if (!isPointerActive && scrollData->pointerScrollActive) {
@@ -3766,12 +4921,15 @@ void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_Vector2 scrollDe
             scrollData->scrollMomentum.y = 0;
         }
         scrollData->scrollPosition.y = CLAY__MIN(CLAY__MAX(scrollData->scrollPosition.y, -(CLAY__MAX(scrollData->contentSize.height - scrollData->layoutElement->dimensions.height, 0))), 0);
+    }
 
-        for (int32_t j = 0; j < context->pointerOverIds.length; ++j) { // TODO n & m are small here but this being n*m gives me the creeps
-            if (scrollData->layoutElement->id == Clay__ElementIdArray_Get(&context->pointerOverIds, j)->id) {
-                highestPriorityElementIndex = j;
-                highestPriorityScrollData = scrollData;
-            }
+    // The innermost hovered scroll container is the one that appears last in pointerOverIds
+    for (int32_t j = (int32_t)context->pointerOverIds.length - 1; j >= 0; --j) {
+        Clay__ScrollContainerDataInternal *scrollData = Clay__GetScrollContainerData(Clay__ElementIdArray_Get(&context->pointerOverIds, j)->id);
+        if (scrollData && scrollData->layoutElement) {
+            highestPriorityElementIndex = j;
+            highestPriorityScrollData = scrollData;
+            break;
         }
     }
 
@@ -3827,6 +4985,258 @@ void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_Vector2 scrollDe
     }
 }
 
+// Compares everything that affects how a render command is drawn, assuming both commands have the same type, except for text contents.
+// Those are compared by Clay__HashRenderCommandText(), as the previous frame's may have been edited in place.
+bool Clay__RenderCommandsEqual(Clay_RenderCommand *a, Clay_RenderCommand *b) {
+    if (a->zIndex != b->zIndex || a->userData != b->userData || !Clay__MemCmp((char *)(&a->boundingBox), (char *)(&b->boundingBox), sizeof(Clay_BoundingBox))) {
+        return false;
+    }
+    switch (a->commandType) {
+        case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: return Clay__MemCmp((char *)(&a->renderData.rectangle), (char *)(&b->renderData.rectangle), sizeof(Clay_RectangleRenderData));
+        case CLAY_RENDER_COMMAND_TYPE_IMAGE: return Clay__MemCmp((char *)(&a->renderData.image), (char *)(&b->renderData.image), sizeof(Clay_ImageRenderData));
+        case CLAY_RENDER_COMMAND_TYPE_CUSTOM: return Clay__MemCmp((char *)(&a->renderData.custom), (char *)(&b->renderData.custom), sizeof(Clay_CustomRenderData));
+        case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+            Clay_TextRenderData *textA = &a->renderData.text;
+            Clay_TextRenderData *textB = &b->renderData.text;
+            return textA->stringContents.length == textB->stringContents.length
+                && Clay__MemCmp((char *)(&textA->textColor), (char *)(&textB->textColor), sizeof(Clay_Color))
+                && textA->fontId == textB->fontId && textA->fontSize == textB->fontSize && textA->letterSpacing == textB->letterSpacing && textA->lineHeight == textB->lineHeight;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+            // Compared field by field, as the struct ends in padding
+            Clay_BorderRenderData *borderA = &a->renderData.border;
+            Clay_BorderRenderData *borderB = &b->renderData.border;
+            return Clay__MemCmp((char *)(&borderA->color), (char *)(&borderB->color), sizeof(Clay_Color))
+                && Clay__MemCmp((char *)(&borderA->cornerRadius), (char *)(&borderB->cornerRadius), sizeof(Clay_CornerRadius))
+                && Clay__MemCmp((char *)(&borderA->width), (char *)(&borderB->width), sizeof(Clay_BorderWidth));
+        }
+        case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: return a->renderData.scroll.horizontal == b->renderData.scroll.horizontal && a->renderData.scroll.vertical == b->renderData.scroll.vertical;
+        default: return true;
+    }
+}
+
+// Hashes a text render command's contents in the same way as the text measurement cache does with hashStringContents set, or returns 0 for other commands
+uint32_t Clay__HashRenderCommandText(Clay_RenderCommand *command) {
+    if (command->commandType != CLAY_RENDER_COMMAND_TYPE_TEXT) {
+        return 0;
+    }
+    Clay_TextRenderData *text = &command->renderData.text;
+    Clay_String contents = { .length = text->stringContents.length, .chars = text->stringContents.chars };
+    Clay_TextElementConfig config = { .fontId = text->fontId, .fontSize = text->fontSize, .letterSpacing = text->letterSpacing, .lineHeight = text->lineHeight, .hashStringContents = true };
+    return Clay__HashTextWithConfig(&contents, &config);
+}
+
+Clay_PackedColor Clay__PackColor(Clay_Color color) {
+    return CLAY__INIT(Clay_PackedColor) {
+        (uint8_t)CLAY__MIN(CLAY__MAX(color.r + 0.5f, 0), 255),
+        (uint8_t)CLAY__MIN(CLAY__MAX(color.g + 0.5f, 0), 255),
+        (uint8_t)CLAY__MIN(CLAY__MAX(color.b + 0.5f, 0), 255),
+        (uint8_t)CLAY__MIN(CLAY__MAX(color.a + 0.5f, 0), 255),
+    };
+}
+
+int16_t Clay__PackCoordinate(float value) {
+    float rounded = value < 0 ? value - 0.5f : value + 0.5f;
+    return (int16_t)CLAY__MIN(CLAY__MAX(rounded, -32768.f), 32767.f);
+}
+
+uint8_t Clay__PackByte(float value) {
+    return (uint8_t)CLAY__MIN(CLAY__MAX(value + 0.5f, 0), 255);
+}
+
+// Writes this frame's render commands to the packed stream, moving anything that doesn't fit in a record to the data table
+void Clay__PackRenderCommands(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__PackedRenderCommandArray *packed = &context->packedRenderCommands;
+    Clay__PackedRenderCommandDataArray *packedData = &context->packedRenderCommandData;
+    packed->length = 0;
+    packedData->length = 0;
+    if (context->renderCommands.length > packed->capacity) {
+        // The element count was raised without resizing the context
+        return;
+    }
+    for (int32_t i = 0; i < context->renderCommands.length; ++i) {
+        Clay_RenderCommand *command = &context->renderCommands.internalArray[i];
+        Clay_PackedRenderCommand *packedCommand = &packed->internalArray[packed->length++];
+        *packedCommand = CLAY__INIT(Clay_PackedRenderCommand) {
+            .x = Clay__PackCoordinate(command->boundingBox.x),
+            .y = Clay__PackCoordinate(command->boundingBox.y),
+            .width = Clay__PackCoordinate(command->boundingBox.width),
+            .height = Clay__PackCoordinate(command->boundingBox.height),
+            .id = command->id,
+            .dataIndex = -1,
+            .zIndex = command->zIndex,
+            .commandType = (uint8_t)command->commandType,
+        };
+        Clay_PackedRenderCommandData data = { .userData = command->userData };
+        Clay_CornerRadius cornerRadius = CLAY__DEFAULT_STRUCT;
+        switch (command->commandType) {
+            case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+                packedCommand->color = Clay__PackColor(command->renderData.rectangle.backgroundColor);
+                cornerRadius = command->renderData.rectangle.cornerRadius;
+                break;
+            }
+            case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+                Clay_BorderRenderData *border = &command->renderData.border;
+                packedCommand->color = Clay__PackColor(border->color);
+                cornerRadius = border->cornerRadius;
+                packedCommand->renderData.borderWidth[0] = (uint8_t)CLAY__MIN(border->width.left, 255);
+                packedCommand->renderData.borderWidth[1] = (uint8_t)CLAY__MIN(border->width.right, 255);
+                packedCommand->renderData.borderWidth[2] = (uint8_t)CLAY__MIN(border->width.top, 255);
+                packedCommand->renderData.borderWidth[3] = (uint8_t)CLAY__MIN(border->width.bottom, 255);
+                break;
+            }
+            case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+                Clay_TextRenderData *text = &command->renderData.text;
+                packedCommand->color = Clay__PackColor(text->textColor);
+                packedCommand->renderData.text.fontId = text->fontId;
+                packedCommand->renderData.text.fontSize = text->fontSize;
+                data.stringContents = text->stringContents;
+                data.letterSpacing = text->letterSpacing;
+                data.lineHeight = text->lineHeight;
+                break;
+            }
+            case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+                Clay_ImageRenderData *image = &command->renderData.image;
+                packedCommand->color = Clay__PackColor(image->backgroundColor);
+                cornerRadius = image->cornerRadius;
+                data.data = image->imageData;
+                data.sourceDimensions = image->sourceDimensions;
+                break;
+            }
+            case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
+                Clay_CustomRenderData *custom = &command->renderData.custom;
+                packedCommand->color = Clay__PackColor(custom->backgroundColor);
+                cornerRadius = custom->cornerRadius;
+                data.data = custom->customData;
+                break;
+            }
+            case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
+                packedCommand->scrollFlags = (uint8_t)((command->renderData.scroll.horizontal ? 1 : 0) | (command->renderData.scroll.vertical ? 2 : 0));
+                break;
+            }
+            default: break;
+        }
+        packedCommand->cornerRadius[0] = Clay__PackByte(cornerRadius.topLeft);
+        packedCommand->cornerRadius[1] = Clay__PackByte(cornerRadius.topRight);
+        packedCommand->cornerRadius[2] = Clay__PackByte(cornerRadius.bottomLeft);
+        packedCommand->cornerRadius[3] = Clay__PackByte(cornerRadius.bottomRight);
+        if (data.userData || data.data || command->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT) {
+            packedCommand->dataIndex = packedData->length;
+            packedData->internalArray[packedData->length++] = data;
+        }
+    }
+}
+
+// Matches this frame's render commands against the previous frame's by id and command type, then keeps a copy of this frame's for next time
+void Clay__CalculateRenderCommandDiff(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay_RenderCommandArray *previous = &context->previousRenderCommands;
+    Clay_RenderCommandArray *current = &context->renderCommands;
+    if (context->renderCommandDiffBuffer.capacity == 0) {
+        // Diffing was enabled during this frame, so the next frame will report everything as added
+        previous->length = 0;
+        return;
+    }
+    Clay__int32_tArray *table = &context->renderCommandDiffTable;
+    int32_t tableSize = 1;
+    while (tableSize < previous->length * 2) {
+        tableSize *= 2;
+    }
+    uint32_t tableMask = (uint32_t)tableSize - 1;
+    for (int32_t i = 0; i < tableSize; ++i) {
+        table->internalArray[i] = -1;
+    }
+    for (int32_t i = 0; i < previous->length; ++i) {
+        Clay_RenderCommand *command = &previous->internalArray[i];
+        uint32_t slot = Clay__HashMix(command->id, command->commandType) & tableMask;
+        while (table->internalArray[slot] != -1) {
+            slot = (slot + 1) & tableMask;
+        }
+        table->internalArray[slot] = i;
+        context->renderCommandDiffMatched.internalArray[i] = false;
+    }
+    // Commands with duplicate ids are matched in the order they appear
+    for (int32_t i = 0; i < current->length; ++i) {
+        Clay_RenderCommand *command = &current->internalArray[i];
+        int32_t match = -1;
+        for (uint32_t slot = Clay__HashMix(command->id, command->commandType) & tableMask; table->internalArray[slot] != -1; slot = (slot + 1) & tableMask) {
+            int32_t previousIndex = table->internalArray[slot];
+            Clay_RenderCommand *previousCommand = &previous->internalArray[previousIndex];
+            if (previousCommand->id == command->id && previousCommand->commandType == command->commandType && !context->renderCommandDiffMatched.internalArray[previousIndex]) {
+                context->renderCommandDiffMatched.internalArray[previousIndex] = true;
+                match = previousIndex;
+                break;
+            }
+        }
+        context->renderCommandDiffMatches.internalArray[i] = match;
+        context->renderCommandDiffTextHashes.internalArray[i] = Clay__HashRenderCommandText(command);
+    }
+
+    Clay_RenderCommandArray *buffer = &context->renderCommandDiffBuffer;
+    buffer->length = 0;
+    for (int32_t i = 0; i < current->length; ++i) {
+        if (context->renderCommandDiffMatches.internalArray[i] == -1) {
+            buffer->internalArray[buffer->length++] = current->internalArray[i];
+        }
+    }
+    int32_t addedCount = buffer->length;
+    for (int32_t i = 0; i < current->length; ++i) {
+        int32_t match = context->renderCommandDiffMatches.internalArray[i];
+        if (match != -1) {
+            if (Clay__RenderCommandsEqual(&current->internalArray[i], &previous->internalArray[match])
+                && context->renderCommandDiffTextHashes.internalArray[i] == context->previousRenderCommandTextHashes.internalArray[match]) {
+                context->renderCommandDiffMatches.internalArray[i] = -1; // Leaves only the changed commands' matches for the loop below
+            } else {
+                buffer->internalArray[buffer->length++] = current->internalArray[i];
+            }
+        }
+    }
+    int32_t changedCount = buffer->length - addedCount;
+    for (int32_t i = 0; i < current->length; ++i) {
+        int32_t match = context->renderCommandDiffMatches.internalArray[i];
+        if (match != -1) {
+            buffer->internalArray[buffer->length++] = previous->internalArray[match];
+        }
+    }
+    for (int32_t i = 0; i < previous->length; ++i) {
+        if (!context->renderCommandDiffMatched.internalArray[i]) {
+            buffer->internalArray[buffer->length++] = previous->internalArray[i];
+        }
+    }
+    int32_t removedCount = buffer->length - addedCount - changedCount * 2;
+    context->renderCommandDiff = CLAY__INIT(Clay_RenderCommandDiff) {
+        .added = { .capacity = addedCount, .length = addedCount, .internalArray = buffer->internalArray },
+        .changed = { .capacity = changedCount, .length = changedCount, .internalArray = buffer->internalArray + addedCount },
+        .changedPrevious = { .capacity = changedCount, .length = changedCount, .internalArray = buffer->internalArray + addedCount + changedCount },
+        .removed = { .capacity = removedCount, .length = removedCount, .internalArray = buffer->internalArray + addedCount + changedCount * 2 },
+    };
+
+    Clay__CopyArrayItems(previous->internalArray, current->internalArray, current->length, sizeof(Clay_RenderCommand));
+    Clay__CopyArrayItems(context->previousRenderCommandTextHashes.internalArray, context->renderCommandDiffTextHashes.internalArray, current->length, sizeof(uint32_t));
+    previous->length = current->length;
+}
+
+// Records how much of the per element ephemeral memory this frame used. Decays slowly, so that one large screen doesn't pin the capacity forever.
+void Clay__UpdateEphemeralHighWaterMark(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (!context->adaptiveMemoryEnabled) {
+        return;
+    }
+    if (context->booleanWarnings.ephemeralCapacityExceeded) {
+        // The frame is incomplete, drop it and retry with the full capacity next frame
+        context->renderCommands.length = 0;
+        context->ephemeralHighWaterMark = context->maxElementCount;
+        Clay__InvalidateRetainedLayout();
+        return;
+    }
+    int32_t used = CLAY__MAX(context->layoutElements.length, context->elementConfigs.length);
+    used = CLAY__MAX(used, context->wrappedTextLines.length);
+    used = CLAY__MAX(used, context->renderCommands.length);
+    used = CLAY__MAX(used, context->dynamicStringData.length);
+    context->ephemeralHighWaterMark = CLAY__MAX(used, context->ephemeralHighWaterMark - context->ephemeralHighWaterMark / 8);
+}
+
 CLAY_WASM_EXPORT("Clay_BeginLayout")
 void Clay_BeginLayout(void) {
     Clay_Context* context = Clay_GetCurrentContext();
@@ -3858,21 +5268,65 @@ Clay_RenderCommandArray Clay_EndLayout(void) {
         Clay__RenderDebugView();
         context->warningsEnabled = true;
     }
-    if (context->booleanWarnings.maxElementsExceeded) {
+    if (context->booleanWarnings.maxElementsExceeded && Clay__EphemeralCapacityReduced(context)) {
+        context->booleanWarnings.ephemeralCapacityExceeded = true;
+    } else if (context->booleanWarnings.maxElementsExceeded) {
         Clay_String message;
         if (!elementsExceededBeforeDebugView) {
             message = CLAY_STRING("Clay Error: Layout elements exceeded Clay__maxElementCount after adding the debug-view to the layout.");
         } else {
             message = CLAY_STRING("Clay Error: Layout elements exceeded Clay__maxElementCount");
         }
+        context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+            .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
+            .errorText = CLAY_STRING("Clay ran out of capacity for layout elements, and the rest of this layout was dropped. Try using Clay_SetMaxElementCount() with a higher value, then Clay_ResizeContext() to apply it between frames."),
+            .userData = context->errorHandler.userData });
         Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand ) {
             .boundingBox = { context->layoutDimensions.width / 2 - 59 * 4, context->layoutDimensions.height / 2, 0, 0 },
             .renderData = { .text = { .stringContents = CLAY__INIT(Clay_StringSlice) { .length = message.length, .chars = message.chars, .baseChars = message.chars }, .textColor = {255, 0, 0, 255}, .fontSize = 16 } },
             .commandType = CLAY_RENDER_COMMAND_TYPE_TEXT
         });
+    } else if (Clay__RetainedLayoutActive(context) && !context->externalScrollHandlingEnabled) {
+        uint32_t frameHash = Clay__HashRetainedFrame();
+        if (frameHash == context->retainedFrameHash && context->layoutDimensions.width == context->retainedLayoutDimensions.width && context->layoutDimensions.height == context->retainedLayoutDimensions.height) {
+            Clay__RestoreRetainedFrame();
+        } else {
+            Clay__CalculateFinalLayout();
+            Clay__StoreRetainedFrame(frameHash);
+        }
     } else {
+        if (context->retainedLayoutEnabled && !Clay__RetainedLayoutActive(context) && !context->retainedLayoutMemoryErrorReported) {
+            context->retainedLayoutMemoryErrorReported = true;
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                .errorType = CLAY_ERROR_TYPE_ARENA_CAPACITY_EXCEEDED,
+                .errorText = CLAY_STRING("Clay retained layout is enabled, but no memory was reserved for it, so it was skipped. Call Clay_ResizeContext() with an arena of at least Clay_MinMemorySize() after enabling it."),
+                .userData = context->errorHandler.userData });
+        }
         Clay__CalculateFinalLayout();
     }
+    Clay__UpdateEphemeralHighWaterMark();
+    if (context->booleanWarnings.ephemeralCapacityExceeded) {
+        // Nothing from this frame will be drawn, so the next diff stays relative to the last frame that was
+        return context->renderCommands;
+    }
+    if (Clay__RenderCommandDiffActive(context)) {
+        Clay__CalculateRenderCommandDiff();
+    } else if (context->renderCommandDiffEnabled && !context->renderCommandDiffMemoryErrorReported) {
+        context->renderCommandDiffMemoryErrorReported = true;
+        context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+            .errorType = CLAY_ERROR_TYPE_ARENA_CAPACITY_EXCEEDED,
+            .errorText = CLAY_STRING("Clay render command diffing is enabled, but no memory was reserved for it, so it was skipped. Call Clay_ResizeContext() with an arena of at least Clay_MinMemorySize() after enabling it."),
+            .userData = context->errorHandler.userData });
+    }
+    if (Clay__PackedRenderCommandsActive(context)) {
+        Clay__PackRenderCommands();
+    } else if (context->packedRenderCommandsEnabled && !context->packedRenderCommandsMemoryErrorReported) {
+        context->packedRenderCommandsMemoryErrorReported = true;
+        context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+            .errorType = CLAY_ERROR_TYPE_ARENA_CAPACITY_EXCEEDED,
+            .errorText = CLAY_STRING("Clay packed render commands are enabled, but no memory was reserved for them, so they were skipped. Call Clay_ResizeContext() with an arena of at least Clay_MinMemorySize() after enabling them."),
+            .userData = context->errorHandler.userData });
+    }
     return context->renderCommands;
 }
 
@@ -3931,20 +5385,63 @@ bool Clay_PointerOver(Clay_ElementId elementId) { // TODO return priority for se
 
 CLAY_WASM_EXPORT("Clay_GetScrollContainerData")
 Clay_ScrollContainerData Clay_GetScrollContainerData(Clay_ElementId id) {
+    Clay__ScrollContainerDataInternal *scrollContainerData = Clay__GetScrollContainerData(id.id);
+    if (scrollContainerData && scrollContainerData->layoutElement) {
+        return CLAY__INIT(Clay_ScrollContainerData) {
+            .scrollPosition = &scrollContainerData->scrollPosition,
+            .scrollContainerDimensions = { scrollContainerData->boundingBox.width, scrollContainerData->boundingBox.height },
+            .contentDimensions = scrollContainerData->contentSize,
+            .config = *Clay__FindElementConfigWithType(scrollContainerData->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig,
+            .found = true
+        };
+    }
+    return CLAY__INIT(Clay_ScrollContainerData) CLAY__DEFAULT_STRUCT;
+}
+
+void Clay__DeclareVirtualListSpacer(float height) {
+    Clay__OpenElement();
+    Clay__ConfigureOpenElement(CLAY__INIT(Clay_ElementDeclaration) { .layout = { .sizing = { .height = CLAY_SIZING_FIXED(height) } } });
+    Clay__CloseElement();
+}
+
+void Clay_VirtualList(Clay_ElementDeclaration declaration, Clay_VirtualListConfig config) {
     Clay_Context* context = Clay_GetCurrentContext();
-    for (int32_t i = 0; i < context->scrollContainerDatas.length; ++i) {
-        Clay__ScrollContainerDataInternal *scrollContainerData = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-        if (scrollContainerData->elementId == id.id) {
-            return CLAY__INIT(Clay_ScrollContainerData) {
-                .scrollPosition = &scrollContainerData->scrollPosition,
-                .scrollContainerDimensions = { scrollContainerData->boundingBox.width, scrollContainerData->boundingBox.height },
-                .contentDimensions = scrollContainerData->contentSize,
-                .config = *Clay__FindElementConfigWithType(scrollContainerData->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_SCROLL).scrollElementConfig,
-                .found = true
-            };
+    declaration.layout.layoutDirection = CLAY_TOP_TO_BOTTOM;
+    declaration.scroll.vertical = true;
+    Clay__OpenElement();
+    Clay__ConfigureOpenElement(declaration);
+    if (context->booleanWarnings.maxElementsExceeded) {
+        Clay__CloseElement();
+        return;
+    }
+    // The list's height isn't known until it has been laid out once, so fall back to the height of the whole layout
+    float scrollOffset = 0;
+    float viewportHeight = context->layoutDimensions.height;
+    Clay__ScrollContainerDataInternal *scrollData = Clay__GetScrollContainerData(Clay__GetOpenLayoutElement()->id);
+    if (scrollData) {
+        scrollOffset = -scrollData->scrollPosition.y - (float)declaration.layout.padding.top;
+        if (scrollData->boundingBox.height > 0) {
+            viewportHeight = scrollData->boundingBox.height;
         }
     }
-    return CLAY__INIT(Clay_ScrollContainerData) CLAY__DEFAULT_STRUCT;
+    float rowStride = CLAY__MAX(config.rowHeight + (float)declaration.layout.childGap, 1);
+    int32_t firstRow = (int32_t)(scrollOffset / rowStride) - config.overscanRowCount;
+    int32_t lastRow = (int32_t)((scrollOffset + viewportHeight) / rowStride) + 1 + config.overscanRowCount;
+    firstRow = CLAY__MIN(CLAY__MAX(firstRow, 0), config.rowCount);
+    lastRow = CLAY__MIN(CLAY__MAX(lastRow, firstRow), config.rowCount);
+    // The gap after each spacer is added by the layout, so spacers are one gap shorter than the rows they replace
+    if (firstRow > 0) {
+        Clay__DeclareVirtualListSpacer((float)firstRow * rowStride - (float)declaration.layout.childGap);
+    }
+    if (config.declareRow) {
+        for (int32_t rowIndex = firstRow; rowIndex < lastRow; ++rowIndex) {
+            config.declareRow(rowIndex, config.userData);
+        }
+    }
+    if (lastRow < config.rowCount) {
+        Clay__DeclareVirtualListSpacer((float)(config.rowCount - lastRow) * rowStride - (float)declaration.layout.childGap);
+    }
+    Clay__CloseElement();
 }
 
 CLAY_WASM_EXPORT("Clay_GetElementData")
@@ -3978,6 +5475,72 @@ void Clay_SetCullingEnabled(bool enabled) {
     context->disableCulling = !enabled;
 }
 
+CLAY_WASM_EXPORT("Clay_SetRetainedLayoutEnabled")
+void Clay_SetRetainedLayoutEnabled(bool enabled) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->retainedLayoutEnabled = enabled;
+    context->retainedLayoutMemoryErrorReported = false;
+    Clay__InvalidateRetainedLayout();
+}
+
+CLAY_WASM_EXPORT("Clay_SetAdaptiveMemoryEnabled")
+void Clay_SetAdaptiveMemoryEnabled(bool enabled) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->adaptiveMemoryEnabled = enabled;
+    // Start from the full capacity and let the high-water mark decay towards what is actually used
+    context->ephemeralHighWaterMark = context->maxElementCount;
+}
+
+CLAY_WASM_EXPORT("Clay_WasLayoutDropped")
+bool Clay_WasLayoutDropped(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return context->booleanWarnings.ephemeralCapacityExceeded;
+}
+
+CLAY_WASM_EXPORT("Clay_SetRenderCommandDiffEnabled")
+void Clay_SetRenderCommandDiffEnabled(bool enabled) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->renderCommandDiffEnabled = enabled;
+    context->renderCommandDiffMemoryErrorReported = false;
+    context->previousRenderCommands.length = 0;
+}
+
+CLAY_WASM_EXPORT("Clay_IsRenderCommandDiffEnabled")
+bool Clay_IsRenderCommandDiffEnabled(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return Clay__RenderCommandDiffActive(context);
+}
+
+CLAY_WASM_EXPORT("Clay_GetRenderCommandDiff")
+Clay_RenderCommandDiff Clay_GetRenderCommandDiff(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return context->renderCommandDiff;
+}
+
+CLAY_WASM_EXPORT("Clay_SetPackedRenderCommandsEnabled")
+void Clay_SetPackedRenderCommandsEnabled(bool enabled) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->packedRenderCommandsEnabled = enabled;
+    context->packedRenderCommandsMemoryErrorReported = false;
+}
+
+CLAY_WASM_EXPORT("Clay_IsPackedRenderCommandsEnabled")
+bool Clay_IsPackedRenderCommandsEnabled(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return Clay__PackedRenderCommandsActive(context);
+}
+
+CLAY_WASM_EXPORT("Clay_GetPackedRenderCommands")
+Clay_PackedRenderCommandStream Clay_GetPackedRenderCommands(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return CLAY__INIT(Clay_PackedRenderCommandStream) {
+        .length = context->packedRenderCommands.length,
+        .commands = context->packedRenderCommands.internalArray,
+        .dataLength = context->packedRenderCommandData.length,
+        .data = context->packedRenderCommandData.internalArray,
+    };
+}
+
 CLAY_WASM_EXPORT("Clay_SetExternalScrollHandlingEnabled")
 void Clay_SetExternalScrollHandlingEnabled(bool enabled) {
     Clay_Context* context = Clay_GetCurrentContext();
@@ -4017,6 +5580,22 @@ void Clay_SetMaxMeasureTextCacheWordCount(int32_t maxMeasureTextCacheWordCount)
     }
 }
 
+CLAY_WASM_EXPORT("Clay_GetMaxScrollContainerCount")
+int32_t Clay_GetMaxScrollContainerCount(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return context->maxScrollContainerCount;
+}
+
+CLAY_WASM_EXPORT("Clay_SetMaxScrollContainerCount")
+void Clay_SetMaxScrollContainerCount(int32_t maxScrollContainerCount) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (context) {
+        context->maxScrollContainerCount = maxScrollContainerCount;
+    } else {
+        Clay__defaultMaxScrollContainerCount = maxScrollContainerCount;
+    }
+}
+
 CLAY_WASM_EXPORT("Clay_ResetMeasureTextCache")
 void Clay_ResetMeasureTextCache(void) {
     Clay_Context* context = Clay_GetCurrentContext();
@@ -4024,12 +5603,12 @@ void Clay_ResetMeasureTextCache(void) {
     context->measureTextHashMapInternalFreeList.length = 0;
     context->measureTextHashMap.length = 0;
     context->measuredWords.length = 0;
-    context->measuredWordsFreeList.length = 0;
     
     for (int32_t i = 0; i < context->measureTextHashMap.capacity; ++i) {
         context->measureTextHashMap.internalArray[i] = 0;
     }
     context->measureTextHashMapInternal.length = 1; // Reserve the 0 value to mean "no next element"
+    Clay__InvalidateRetainedLayout();
 }
 
 #endif // CLAY_IMPLEMENTATION
@@ -1,9 +1,11 @@
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 #include "stdint.h"
 #include "string.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "stddef.h"
 
 
 #define CLAY_RECTANGLE_TO_RAYLIB_RECTANGLE(rectangle) (Rectangle) { .x = rectangle.x, .y = rectangle.y, .width = rectangle.width, .height = rectangle.height }
@@ -82,6 +84,524 @@ Ray GetScreenToWorldPointWithZDistance(Vector2 position, Camera camera, int scre
 }
 
 
+void Clay_Raylib_Initialize(int width, int height, const char *title, unsigned int flags) {
+    SetConfigFlags(flags);
+    InitWindow(width, height, title);
+//    EnableEventWaiting();
+}
+
+// Scratch buffers for batching render commands by texture, grown as needed. Call Clay_Raylib_Close() to free
+static int *batch_pending = NULL;
+static unsigned int *batch_keys = NULL;
+static int *batch_order = NULL;
+static int batch_capacity = 0;
+
+typedef struct
+{
+    // The number of texture batches drawn, each of which costs one of rlgl's RL_DEFAULT_BATCH_DRAWCALLS. Includes the texture switches within
+    // text that draws glyphs from more than one of its font's texture and the glyph atlas pages.
+    int drawCalls;
+    // How many more there would have been if commands were drawn in the order Clay emitted them
+    int drawCallsSaved;
+} Clay_Raylib_BatchStats;
+
+static Clay_Raylib_BatchStats batch_stats = { 0 };
+
+// The quads of a line of text, cached across frames by render command id so that unchanged text isn't laid out again.
+// Positions are relative to the command's position, so a run stays valid when the text only moves.
+typedef struct
+{
+    uint32_t id;
+    uint32_t textHash;
+    int textLength;
+    int fontId;
+    unsigned int textureId;
+    float fontSize;
+    float letterSpacing;
+    // Set if any glyph came from the glyph atlas, in which case the run is only valid until the atlas evicts a page
+    bool usesAtlas;
+    uint32_t atlasEpoch;
+    // The frame this run was last drawn in
+    uint32_t generation;
+    // Index + 1 of the next run in the same bucket, or of the next free run
+    int nextIndex;
+    int quadCount;
+    int quadCapacity;
+    // 4 vertices per quad, x and y each
+    float *positions;
+    float *texcoords;
+    // The glyph atlas page each quad is drawn from, or -1 for the font's own texture
+    int *pages;
+} Clay_Raylib__GlyphRun;
+
+#define CLAY_RAYLIB_GLYPH_RUN_BUCKETS 1024
+// Runs that aren't drawn for this many frames are evicted
+#define CLAY_RAYLIB_GLYPH_RUN_MAX_AGE 2
+
+// Glyph runs, grown as needed. Call Clay_Raylib_Close() to free
+static Clay_Raylib__GlyphRun *glyph_runs = NULL;
+static int glyph_runs_length = 0;
+static int glyph_runs_capacity = 0;
+// Index + 1 of the first run in each bucket, 0 if empty
+static int glyph_run_buckets[CLAY_RAYLIB_GLYPH_RUN_BUCKETS] = { 0 };
+// Index + 1 of the first evicted run, whose arrays are kept for reuse
+static int glyph_run_free_list = 0;
+static uint32_t glyph_run_generation = 0;
+
+// A glyph as it is drawn, from either a font's own texture or the glyph atlas
+typedef struct
+{
+    // The glyph's rectangle in its texture, excluding padding
+    Rectangle source;
+    float padding;
+    float offsetX;
+    float offsetY;
+    float advanceX;
+    // The glyph atlas page holding the glyph, or -1 for the font's own texture
+    int page;
+} Clay_Raylib__Glyph;
+
+#define CLAY_RAYLIB_MAX_DYNAMIC_FONTS 16
+#define CLAY_RAYLIB_GLYPH_PAGE_SIZE 512
+#define CLAY_RAYLIB_GLYPH_PAGE_MAX_SHELVES 64
+// Space left around glyphs in atlas pages, so that filtering never samples a neighbouring glyph
+#define CLAY_RAYLIB_GLYPH_PAGE_SPACING 2
+// The memory the glyph atlas keeps pages in. Past it, the least recently used page is cleared for reuse.
+// Pages are 2 bytes per pixel, and each is held once in RAM and once as a texture, both of which count towards the budget.
+#define CLAY_RAYLIB_GLYPH_ATLAS_BUDGET (8 * 1024 * 1024)
+#define CLAY_RAYLIB_ATLAS_GLYPH_BUCKETS 1024
+
+// The font file of a font registered with Clay_Raylib_LoadDynamicGlyphs(), kept to rasterize glyphs from
+typedef struct
+{
+    unsigned char *fileData;
+    int fileSize;
+} Clay_Raylib__DynamicFont;
+
+// A row of glyphs in an atlas page. Glyphs are placed left to right in the first shelf tall enough for them, or in a new shelf below the last.
+typedef struct
+{
+    int y;
+    int height;
+    int x;
+} Clay_Raylib__GlyphShelf;
+
+typedef struct
+{
+    // Gray and alpha, like the atlases raylib generates for fonts
+    Image image;
+    // Created when first drawn from, then updated whenever glyphs were added since
+    Texture2D texture;
+    bool dirty;
+    // The frame this page was last used in
+    uint32_t lastUsed;
+    Clay_Raylib__GlyphShelf shelves[CLAY_RAYLIB_GLYPH_PAGE_MAX_SHELVES];
+    int shelfCount;
+} Clay_Raylib__GlyphPage;
+
+typedef struct
+{
+    int fontId;
+    int codepoint;
+    Clay_Raylib__Glyph glyph;
+    // Index + 1 of the next glyph in the same bucket, or of the next free glyph
+    int nextIndex;
+} Clay_Raylib__AtlasGlyph;
+
+// The glyph atlas, holding glyphs rasterized on first use for fonts registered with Clay_Raylib_LoadDynamicGlyphs(). Call Clay_Raylib_Close() to free
+static Clay_Raylib__DynamicFont dynamic_fonts[CLAY_RAYLIB_MAX_DYNAMIC_FONTS] = { 0 };
+static Clay_Raylib__GlyphPage *glyph_pages = NULL;
+static int glyph_pages_length = 0;
+static Clay_Raylib__AtlasGlyph *atlas_glyphs = NULL;
+static int atlas_glyphs_length = 0;
+static int atlas_glyphs_capacity = 0;
+// Index + 1 of the first glyph in each bucket, 0 if empty
+static int atlas_glyph_buckets[CLAY_RAYLIB_ATLAS_GLYPH_BUCKETS] = { 0 };
+// Index + 1 of the first glyph removed by an eviction
+static int atlas_glyph_free_list = 0;
+// Incremented whenever a page is evicted, invalidating glyph runs drawn from the atlas
+static uint32_t glyph_atlas_epoch = 0;
+
+// Draws rounded rectangles and borders from an instance array, one quad per Clay_Raylib__ShapeInstance, filled using a signed distance to
+// the rounded box. Borders are the same box with the inner box, shrunk by the border widths, cut out of it.
+// The parameters are read from the instance buffer rather than from rlgl's batch, which normalizes its normals.
+static const char *shape_vertex_shader =
+    "#version 330\n"
+    "in vec2 vertexPosition;\n"
+    "in vec4 vertexTexCoord;\n"
+    "in vec4 vertexNormal;\n"
+    "in vec4 vertexTangent;\n"
+    "in vec4 vertexColor;\n"
+    "uniform mat4 mvp;\n"
+    "out vec2 fragLocal;\n"
+    "out vec2 fragSize;\n"
+    "out vec4 fragRadius;\n"
+    "out vec4 fragBorder;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragLocal = vertexPosition * vertexTexCoord.zw;\n"
+    "    fragSize = vertexTexCoord.zw;\n"
+    "    fragRadius = vertexNormal;\n"
+    "    fragBorder = vertexTangent;\n"
+    "    fragColor = vertexColor;\n"
+    "    gl_Position = mvp * vec4(vertexTexCoord.xy + fragLocal, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *shape_fragment_shader =
+    "#version 330\n"
+    "in vec2 fragLocal;\n"
+    "in vec2 fragSize;\n"
+    "in vec4 fragRadius;\n"
+    "in vec4 fragBorder;\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "float roundedBoxDistance(vec2 position, vec2 halfSize, float radius) {\n"
+    "    vec2 q = abs(position) - halfSize + radius;\n"
+    "    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;\n"
+    "}\n"
+    "void main() {\n"
+    "    vec2 halfSize = fragSize * 0.5;\n"
+    "    bool left = fragLocal.x < halfSize.x;\n"
+    "    bool top = fragLocal.y < halfSize.y;\n"
+    "    float radius = min(left ? (top ? fragRadius.x : fragRadius.z) : (top ? fragRadius.y : fragRadius.w), min(halfSize.x, halfSize.y));\n"
+    "    float coverage = clamp(0.5 - roundedBoxDistance(fragLocal - halfSize, halfSize, radius), 0.0, 1.0);\n"
+    "    if (fragBorder != vec4(0.0)) {\n"
+    "        vec2 innerMin = vec2(fragBorder.x, fragBorder.z);\n"
+    "        vec2 innerMax = fragSize - vec2(fragBorder.y, fragBorder.w);\n"
+    "        vec2 innerHalfSize = max((innerMax - innerMin) * 0.5, 0.0);\n"
+    "        float innerRadius = max(radius - max(left ? fragBorder.x : fragBorder.y, top ? fragBorder.z : fragBorder.w), 0.0);\n"
+    "        innerRadius = min(innerRadius, min(innerHalfSize.x, innerHalfSize.y));\n"
+    "        coverage *= clamp(0.5 + roundedBoxDistance(fragLocal - (innerMin + innerMax) * 0.5, innerHalfSize, innerRadius), 0.0, 1.0);\n"
+    "    }\n"
+    "    finalColor = vec4(fragColor.rgb, fragColor.a * coverage);\n"
+    "}\n";
+
+typedef struct
+{
+    float x, y, width, height;
+    // topLeft, topRight, bottomLeft, bottomRight
+    unsigned char cornerRadius[4];
+    // left, right, top, bottom. All zero for a filled rectangle.
+    unsigned char borderWidth[4];
+    unsigned char r, g, b, a;
+} Clay_Raylib__ShapeInstance;
+
+// Rectangles and borders waiting to be drawn together. Consecutive shape commands are gathered here, then uploaded to the persistent instance
+// buffer and drawn with one instanced draw call when anything else needs drawing. Loaded on first use, and left unloaded where the shader
+// can't be compiled, e.g. without OpenGL 3.3, in which case shapes are tessellated instead.
+static Shader shape_shader = { 0 };
+static bool shape_shader_attempted = false;
+static unsigned int shape_vertex_array = 0;
+static unsigned int shape_corner_buffer = 0;
+static unsigned int shape_instance_buffer = 0;
+static int shape_instance_buffer_capacity = 0;
+// Where this frame's next instances go in the instance buffer, so that no region is overwritten while earlier draws may still read it
+static int shape_instance_buffer_cursor = 0;
+static Clay_Raylib__ShapeInstance *shape_instances = NULL;
+static int shape_instances_length = 0;
+static int shape_instances_capacity = 0;
+
+// The previous frame, kept by Clay_Raylib_RenderDamaged() so that only damaged regions need to be redrawn
+static RenderTexture2D damage_render_target = { 0 };
+// Scissor rectangles are in Clay's coordinates, but the render texture has the window's render resolution, which is larger on high DPI displays
+static Vector2 scissor_scale = { 1, 1 };
+
+// Call after closing the window to clean up the render buffer
+void Clay_Raylib_Close()
+{
+    free(batch_pending);
+    free(batch_keys);
+    free(batch_order);
+    batch_pending = NULL;
+    batch_keys = NULL;
+    batch_order = NULL;
+    batch_capacity = 0;
+    for (int i = 0; i < glyph_runs_length; i++) {
+        free(glyph_runs[i].positions);
+        free(glyph_runs[i].texcoords);
+        free(glyph_runs[i].pages);
+    }
+    free(glyph_runs);
+    glyph_runs = NULL;
+    glyph_runs_length = 0;
+    glyph_runs_capacity = 0;
+    memset(glyph_run_buckets, 0, sizeof(glyph_run_buckets));
+    glyph_run_free_list = 0;
+    for (int i = 0; i < glyph_pages_length; i++) {
+        if (glyph_pages[i].texture.id) UnloadTexture(glyph_pages[i].texture);
+        free(glyph_pages[i].image.data);
+    }
+    free(glyph_pages);
+    glyph_pages = NULL;
+    glyph_pages_length = 0;
+    free(atlas_glyphs);
+    atlas_glyphs = NULL;
+    atlas_glyphs_length = 0;
+    atlas_glyphs_capacity = 0;
+    memset(atlas_glyph_buckets, 0, sizeof(atlas_glyph_buckets));
+    atlas_glyph_free_list = 0;
+    for (int i = 0; i < CLAY_RAYLIB_MAX_DYNAMIC_FONTS; i++) {
+        if (dynamic_fonts[i].fileData) UnloadFileData(dynamic_fonts[i].fileData);
+        dynamic_fonts[i] = (Clay_Raylib__DynamicFont) { 0 };
+    }
+    if(damage_render_target.id) UnloadRenderTexture(damage_render_target);
+    damage_render_target = (RenderTexture2D) { 0 };
+
+    shape_shader_attempted = false;
+    if(shape_shader.id) {
+        UnloadShader(shape_shader);
+        rlUnloadVertexArray(shape_vertex_array);
+        rlUnloadVertexBuffer(shape_corner_buffer);
+        rlUnloadVertexBuffer(shape_instance_buffer);
+    }
+    shape_shader = (Shader) { 0 };
+    shape_vertex_array = 0;
+    shape_corner_buffer = 0;
+    shape_instance_buffer = 0;
+    shape_instance_buffer_capacity = 0;
+    free(shape_instances);
+    shape_instances = NULL;
+    shape_instances_length = 0;
+    shape_instances_capacity = 0;
+
+    CloseWindow();
+}
+
+
+static inline bool Clay_Raylib__BoxesOverlap(Clay_BoundingBox a, Clay_BoundingBox b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static inline Clay_BoundingBox Clay_Raylib__BoxUnion(Clay_BoundingBox a, Clay_BoundingBox b) {
+    float x = fminf(a.x, b.x);
+    float y = fminf(a.y, b.y);
+    return (Clay_BoundingBox) { x, y, fmaxf(a.x + a.width, b.x + b.width) - x, fmaxf(a.y + a.height, b.y + b.height) - y };
+}
+
+static inline Clay_BoundingBox Clay_Raylib__BoxIntersection(Clay_BoundingBox a, Clay_BoundingBox b) {
+    float x = fmaxf(a.x, b.x);
+    float y = fmaxf(a.y, b.y);
+    return (Clay_BoundingBox) { x, y, fmaxf(fminf(a.x + a.width, b.x + b.width) - x, 0), fmaxf(fminf(a.y + a.height, b.y + b.height) - y, 0) };
+}
+
+// The drawing of each primitive, shared by the full and packed render command paths
+
+// Matches raylib's default, see SetTextLineSpacing()
+#define CLAY_RAYLIB_TEXT_LINE_SPACING 2
+
+// Decodes the UTF-8 codepoint at text.chars[i] without reading past the end of the slice.
+// Invalid sequences decode to '?' one byte at a time, as in GetCodepointNext().
+static inline int Clay_Raylib__DecodeCodepoint(Clay_StringSlice text, int i, int *byteCount)
+{
+    const unsigned char *bytes = (const unsigned char *)text.chars + i;
+    *byteCount = 1;
+    if (bytes[0] < 0x80) return bytes[0];
+    int length = (bytes[0] & 0xE0) == 0xC0 ? 2 : (bytes[0] & 0xF0) == 0xE0 ? 3 : (bytes[0] & 0xF8) == 0xF0 ? 4 : 0;
+    if (length == 0 || length > text.length - i) return '?';
+    int codepoint = bytes[0] & (0x7F >> length);
+    for (int k = 1; k < length; k++) {
+        if ((bytes[k] & 0xC0) != 0x80) return '?';
+        codepoint = (codepoint << 6) | (bytes[k] & 0x3F);
+    }
+    *byteCount = length;
+    return codepoint;
+}
+
+// Finds room for a glyph in the page, opening a new shelf if none of the existing ones fit it
+static bool Clay_Raylib__PackGlyph(Clay_Raylib__GlyphPage *page, int width, int height, int *x, int *y)
+{
+    width += CLAY_RAYLIB_GLYPH_PAGE_SPACING;
+    height += CLAY_RAYLIB_GLYPH_PAGE_SPACING;
+    for (int i = 0; i < page->shelfCount; i++) {
+        Clay_Raylib__GlyphShelf *shelf = &page->shelves[i];
+        if (height <= shelf->height && shelf->x + width <= CLAY_RAYLIB_GLYPH_PAGE_SIZE) {
+            *x = shelf->x;
+            *y = shelf->y;
+            shelf->x += width;
+            return true;
+        }
+    }
+    int top = page->shelfCount > 0 ? page->shelves[page->shelfCount - 1].y + page->shelves[page->shelfCount - 1].height : 0;
+    if (page->shelfCount == CLAY_RAYLIB_GLYPH_PAGE_MAX_SHELVES || top + height > CLAY_RAYLIB_GLYPH_PAGE_SIZE || width > CLAY_RAYLIB_GLYPH_PAGE_SIZE) {
+        return false;
+    }
+    page->shelves[page->shelfCount++] = (Clay_Raylib__GlyphShelf) { top, height, width };
+    *x = 0;
+    *y = top;
+    return true;
+}
+
+static void Clay_Raylib__ClearGlyphPage(Clay_Raylib__GlyphPage *page)
+{
+    // White and transparent, so that filtering at glyph edges doesn't darken them
+    unsigned char *pixels = page->image.data;
+    for (int i = 0; i < CLAY_RAYLIB_GLYPH_PAGE_SIZE * CLAY_RAYLIB_GLYPH_PAGE_SIZE; i++) {
+        pixels[i * 2] = 255;
+        pixels[i * 2 + 1] = 0;
+    }
+    page->shelfCount = 0;
+    page->dirty = true;
+}
+
+// Returns a page with room for new glyphs. Past the memory budget, the least recently used page is evicted, along with its glyphs.
+// Pages used in the current frame might still be read by batched draws, so if every page is in use the budget is exceeded instead.
+static int Clay_Raylib__AcquireGlyphPage(void)
+{
+    int pageBytes = CLAY_RAYLIB_GLYPH_PAGE_SIZE * CLAY_RAYLIB_GLYPH_PAGE_SIZE * 2;
+    int evicted = -1;
+    // The image in RAM, and the texture made from it
+    if ((glyph_pages_length + 1) * pageBytes * 2 > CLAY_RAYLIB_GLYPH_ATLAS_BUDGET) {
+        for (int i = 0; i < glyph_pages_length; i++) {
+            if (glyph_pages[i].lastUsed != glyph_run_generation && (evicted < 0 || glyph_pages[i].lastUsed < glyph_pages[evicted].lastUsed)) {
+                evicted = i;
+            }
+        }
+    }
+    if (evicted >= 0) {
+        for (int i = 0; i < CLAY_RAYLIB_ATLAS_GLYPH_BUCKETS; i++) {
+            int *link = &atlas_glyph_buckets[i];
+            while (*link) {
+                int index = *link;
+                Clay_Raylib__AtlasGlyph *glyph = &atlas_glyphs[index - 1];
+                if (glyph->glyph.page == evicted) {
+                    *link = glyph->nextIndex;
+                    glyph->nextIndex = atlas_glyph_free_list;
+                    atlas_glyph_free_list = index;
+                } else {
+                    link = &glyph->nextIndex;
+                }
+            }
+        }
+        Clay_Raylib__ClearGlyphPage(&glyph_pages[evicted]);
+        glyph_atlas_epoch++;
+        return evicted;
+    }
+    glyph_pages = realloc(glyph_pages, (glyph_pages_length + 1) * sizeof(Clay_Raylib__GlyphPage));
+    Clay_Raylib__GlyphPage *page = &glyph_pages[glyph_pages_length];
+    *page = (Clay_Raylib__GlyphPage) { 0 };
+    page->image = (Image) { malloc(pageBytes), CLAY_RAYLIB_GLYPH_PAGE_SIZE, CLAY_RAYLIB_GLYPH_PAGE_SIZE, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA };
+    Clay_Raylib__ClearGlyphPage(page);
+    return glyph_pages_length++;
+}
+
+// Rasterizes the codepoint from the registered font file into the atlas. Returns false if it can't be rasterized or doesn't fit in a page.
+static bool Clay_Raylib__RasterizeGlyph(Clay_Raylib__DynamicFont *dynamicFont, Font *font, int codepoint, Clay_Raylib__Glyph *glyph)
+{
+    GlyphInfo *info = LoadFontData(dynamicFont->fileData, dynamicFont->fileSize, font->baseSize, &codepoint, 1, FONT_DEFAULT);
+    if (!info) return false;
+    *glyph = (Clay_Raylib__Glyph) { .offsetX = (float)info->offsetX, .offsetY = (float)info->offsetY, .advanceX = (float)info->advanceX, .page = -1 };
+    // Glyphs such as spaces have no image, so there's nothing to place in the atlas
+    bool rasterized = true;
+    int width = info->image.width;
+    int height = info->image.height;
+    if (width > 0 && height > 0 && info->image.data) {
+        int x = 0;
+        int y = 0;
+        int pageIndex = -1;
+        for (int i = 0; i < glyph_pages_length && pageIndex < 0; i++) {
+            if (Clay_Raylib__PackGlyph(&glyph_pages[i], width, height, &x, &y)) pageIndex = i;
+        }
+        if (pageIndex < 0) {
+            pageIndex = Clay_Raylib__AcquireGlyphPage();
+            if (!Clay_Raylib__PackGlyph(&glyph_pages[pageIndex], width, height, &x, &y)) pageIndex = -1;
+        }
+        if (pageIndex >= 0) {
+            Clay_Raylib__GlyphPage *page = &glyph_pages[pageIndex];
+            unsigned char *source = info->image.data;
+            unsigned char *pixels = page->image.data;
+            for (int row = 0; row < height; row++) {
+                for (int column = 0; column < width; column++) {
+                    pixels[((y + row) * CLAY_RAYLIB_GLYPH_PAGE_SIZE + x + column) * 2 + 1] = source[row * width + column];
+                }
+            }
+            page->dirty = true;
+            page->lastUsed = glyph_run_generation;
+            glyph->source = (Rectangle) { (float)x, (float)y, (float)width, (float)height };
+            glyph->page = pageIndex;
+        } else {
+            rasterized = false;
+        }
+    }
+    UnloadFontData(info, 1);
+    return rasterized;
+}
+
+// Looks the codepoint up in the glyph atlas, rasterizing it on first use
+static bool Clay_Raylib__GetAtlasGlyph(int fontId, Font *font, int codepoint, Clay_Raylib__Glyph *glyph)
+{
+    int *bucket = &atlas_glyph_buckets[(uint32_t)(codepoint * 31 + fontId) % CLAY_RAYLIB_ATLAS_GLYPH_BUCKETS];
+    for (int index = *bucket; index; index = atlas_glyphs[index - 1].nextIndex) {
+        Clay_Raylib__AtlasGlyph *atlasGlyph = &atlas_glyphs[index - 1];
+        if (atlasGlyph->codepoint == codepoint && atlasGlyph->fontId == fontId) {
+            if (atlasGlyph->glyph.page >= 0) glyph_pages[atlasGlyph->glyph.page].lastUsed = glyph_run_generation;
+            *glyph = atlasGlyph->glyph;
+            return true;
+        }
+    }
+    if (!Clay_Raylib__RasterizeGlyph(&dynamic_fonts[fontId], font, codepoint, glyph)) return false;
+    int index = atlas_glyph_free_list;
+    if (index) {
+        atlas_glyph_free_list = atlas_glyphs[index - 1].nextIndex;
+    } else {
+        if (atlas_glyphs_length == atlas_glyphs_capacity) {
+            atlas_glyphs_capacity = atlas_glyphs_capacity ? atlas_glyphs_capacity * 2 : 256;
+            atlas_glyphs = realloc(atlas_glyphs, atlas_glyphs_capacity * sizeof(Clay_Raylib__AtlasGlyph));
+        }
+        index = ++atlas_glyphs_length;
+    }
+    // Rasterizing may have evicted a page, which can change this bucket, so it is linked only now
+    atlas_glyphs[index - 1] = (Clay_Raylib__AtlasGlyph) { fontId, codepoint, *glyph, *bucket };
+    *bucket = index;
+    return true;
+}
+
+// Returns the glyph for the codepoint from the font, or from the glyph atlas if the font wasn't loaded with it and has dynamic glyphs.
+// Codepoints found in neither use the font's fallback glyph, as in GetGlyphIndex().
+static Clay_Raylib__Glyph Clay_Raylib__GetGlyph(int fontId, Font *font, int codepoint)
+{
+    // Fonts loaded without a codepoint list hold consecutive codepoints from 32, so try that before GetGlyphIndex()'s search
+    int index = codepoint - 32;
+    if (index < 0 || index >= font->glyphCount || font->glyphs[index].value != codepoint) {
+        index = GetGlyphIndex(*font, codepoint);
+        Clay_Raylib__Glyph glyph;
+        if (font->glyphs[index].value != codepoint && fontId >= 0 && fontId < CLAY_RAYLIB_MAX_DYNAMIC_FONTS && dynamic_fonts[fontId].fileData
+            && Clay_Raylib__GetAtlasGlyph(fontId, font, codepoint, &glyph)) {
+            return glyph;
+        }
+    }
+    GlyphInfo *info = &font->glyphs[index];
+    return (Clay_Raylib__Glyph) { font->recs[index], (float)font->glyphPadding, (float)info->offsetX, (float)info->offsetY, (float)info->advanceX, -1 };
+}
+
+// Binds the page's texture for drawing, creating or updating it first if needed
+static unsigned int Clay_Raylib__UseGlyphPage(int pageIndex)
+{
+    Clay_Raylib__GlyphPage *page = &glyph_pages[pageIndex];
+    page->lastUsed = glyph_run_generation;
+    if (!page->texture.id) {
+        page->texture = LoadTextureFromImage(page->image);
+        SetTextureFilter(page->texture, TEXTURE_FILTER_BILINEAR);
+    } else if (page->dirty) {
+        UpdateTexture(page->texture, page->image.data);
+    }
+    page->dirty = false;
+    return page->texture.id;
+}
+
+// Lets fonts[fontId] measure and draw codepoints it wasn't loaded with, such as accented or CJK characters. Each one is rasterized from the
+// font file at the font's base size the first time it's needed, into atlas pages shared by all fonts, see CLAY_RAYLIB_GLYPH_ATLAS_BUDGET.
+// Call after loading the font. Returns false if the file couldn't be read.
+bool Clay_Raylib_LoadDynamicGlyphs(int fontId, const char *fileName)
+{
+    if (fontId < 0 || fontId >= CLAY_RAYLIB_MAX_DYNAMIC_FONTS) return false;
+    int fileSize = 0;
+    unsigned char *fileData = LoadFileData(fileName, &fileSize);
+    if (!fileData) return false;
+    if (dynamic_fonts[fontId].fileData) UnloadFileData(dynamic_fonts[fontId].fileData);
+    dynamic_fonts[fontId] = (Clay_Raylib__DynamicFont) { fileData, fileSize };
+    return true;
+}
+
 static inline Clay_Dimensions Raylib_MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
     // Measure string size for Font
     Clay_Dimensions textSize = { 0 };
@@ -100,16 +620,19 @@ static inline Clay_Dimensions Raylib_MeasureText(Clay_StringSlice text, Clay_Tex
 
     float scaleFactor = config->fontSize/(float)fontToUse.baseSize;
 
-    for (int i = 0; i < text.length; ++i)
+    for (int i = 0; i < text.length;)
     {
-        if (text.chars[i] == '\n') {
+        int byteCount;
+        int codepoint = Clay_Raylib__DecodeCodepoint(text, i, &byteCount);
+        i += byteCount;
+        if (codepoint == '\n') {
             maxTextWidth = fmax(maxTextWidth, lineTextWidth);
             lineTextWidth = 0;
             continue;
         }
-        int index = text.chars[i] - 32;
-        if (fontToUse.glyphs[index].advanceX != 0) lineTextWidth += fontToUse.glyphs[index].advanceX;
-        else lineTextWidth += (fontToUse.recs[index].width + fontToUse.glyphs[index].offsetX);
+        Clay_Raylib__Glyph glyph = Clay_Raylib__GetGlyph(config->fontId, &fontToUse, codepoint);
+        if (glyph.advanceX != 0) lineTextWidth += glyph.advanceX;
+        else lineTextWidth += (glyph.source.width + glyph.offsetX);
     }
 
     maxTextWidth = fmax(maxTextWidth, lineTextWidth);
@@ -120,135 +643,618 @@ static inline Clay_Dimensions Raylib_MeasureText(Clay_StringSlice text, Clay_Tex
     return textSize;
 }
 
-void Clay_Raylib_Initialize(int width, int height, const char *title, unsigned int flags) {
-    SetConfigFlags(flags);
-    InitWindow(width, height, title);
-//    EnableEventWaiting();
+// Lays out the text into the run, with positions relative to the top left of the text. Matches DrawTextEx(), including its
+// use of DrawTexturePro() for each glyph.
+static void Clay_Raylib__BuildGlyphRun(Clay_Raylib__GlyphRun *run, int fontId, Font font, Clay_StringSlice text, float fontSize, float letterSpacing)
+{
+    if (text.length > run->quadCapacity) {
+        free(run->positions);
+        free(run->texcoords);
+        free(run->pages);
+        run->quadCapacity = text.length;
+        run->positions = malloc(run->quadCapacity * 8 * sizeof(float));
+        run->texcoords = malloc(run->quadCapacity * 8 * sizeof(float));
+        run->pages = malloc(run->quadCapacity * sizeof(int));
+    }
+    float scaleFactor = fontSize / (float)font.baseSize;
+    float offsetX = 0;
+    float offsetY = 0;
+    run->quadCount = 0;
+    run->usesAtlas = false;
+
+    for (int i = 0; i < text.length;) {
+        int byteCount;
+        int codepoint = Clay_Raylib__DecodeCodepoint(text, i, &byteCount);
+        i += byteCount;
+        if (codepoint == '\n') {
+            offsetY += fontSize + CLAY_RAYLIB_TEXT_LINE_SPACING;
+            offsetX = 0;
+            continue;
+        }
+        Clay_Raylib__Glyph glyph = Clay_Raylib__GetGlyph(fontId, &font, codepoint);
+        Rectangle source = glyph.source;
+        if (glyph.page >= 0) run->usesAtlas = true;
+        if (codepoint != ' ' && codepoint != '\t' && source.width > 0 && source.height > 0) {
+            float padding = glyph.padding;
+            float textureWidth = glyph.page >= 0 ? CLAY_RAYLIB_GLYPH_PAGE_SIZE : (float)font.texture.width;
+            float textureHeight = glyph.page >= 0 ? CLAY_RAYLIB_GLYPH_PAGE_SIZE : (float)font.texture.height;
+            float x = offsetX + (glyph.offsetX - padding) * scaleFactor;
+            float y = offsetY + (glyph.offsetY - padding) * scaleFactor;
+            float width = (source.width + 2 * padding) * scaleFactor;
+            float height = (source.height + 2 * padding) * scaleFactor;
+            float u0 = (source.x - padding) / textureWidth;
+            float v0 = (source.y - padding) / textureHeight;
+            float u1 = (source.x + source.width + padding) / textureWidth;
+            float v1 = (source.y + source.height + padding) / textureHeight;
+            // Top left, bottom left, bottom right, top right
+            float *positions = &run->positions[run->quadCount * 8];
+            float *texcoords = &run->texcoords[run->quadCount * 8];
+            positions[0] = x;         positions[1] = y;          texcoords[0] = u0; texcoords[1] = v0;
+            positions[2] = x;         positions[3] = y + height; texcoords[2] = u0; texcoords[3] = v1;
+            positions[4] = x + width; positions[5] = y + height; texcoords[4] = u1; texcoords[5] = v1;
+            positions[6] = x + width; positions[7] = y;          texcoords[6] = u1; texcoords[7] = v0;
+            run->pages[run->quadCount] = glyph.page;
+            run->quadCount++;
+        }
+        offsetX += (glyph.advanceX != 0 ? glyph.advanceX : source.width) * scaleFactor + letterSpacing;
+    }
 }
 
-// A MALLOC'd buffer, that we keep modifying inorder to save from so many Malloc and Free Calls.
-// Call Clay_Raylib_Close() to free
-static char *temp_render_buffer = NULL;
-static int temp_render_buffer_len = 0;
+static uint32_t Clay_Raylib__HashText(Clay_StringSlice text)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < text.length; i++) {
+        hash = (hash ^ (unsigned char)text.chars[i]) * 16777619u;
+    }
+    return hash;
+}
 
-// Call after closing the window to clean up the render buffer
-void Clay_Raylib_Close()
+// Returns the cached run for the text command as it was last drawn, or NULL if there is none
+static Clay_Raylib__GlyphRun *Clay_Raylib__FindGlyphRun(uint32_t id)
 {
-    if(temp_render_buffer) free(temp_render_buffer);
-    temp_render_buffer_len = 0;
+    for (int index = glyph_run_buckets[id % CLAY_RAYLIB_GLYPH_RUN_BUCKETS]; index; index = glyph_runs[index - 1].nextIndex) {
+        if (glyph_runs[index - 1].id == id) return &glyph_runs[index - 1];
+    }
+    return NULL;
+}
 
-    CloseWindow();
+// Returns the cached run for the text command, laying it out again if the text, font, size or spacing changed since it was cached
+static Clay_Raylib__GlyphRun *Clay_Raylib__GetGlyphRun(uint32_t id, int fontId, Font font, Clay_StringSlice text, float fontSize, float letterSpacing)
+{
+    uint32_t textHash = Clay_Raylib__HashText(text);
+    int *bucket = &glyph_run_buckets[id % CLAY_RAYLIB_GLYPH_RUN_BUCKETS];
+    Clay_Raylib__GlyphRun *run = Clay_Raylib__FindGlyphRun(id);
+    if (!run) {
+        int index = glyph_run_free_list;
+        if (index) {
+            glyph_run_free_list = glyph_runs[index - 1].nextIndex;
+        } else {
+            if (glyph_runs_length == glyph_runs_capacity) {
+                glyph_runs_capacity = glyph_runs_capacity ? glyph_runs_capacity * 2 : 256;
+                glyph_runs = realloc(glyph_runs, glyph_runs_capacity * sizeof(Clay_Raylib__GlyphRun));
+            }
+            glyph_runs[glyph_runs_length] = (Clay_Raylib__GlyphRun) { 0 };
+            index = ++glyph_runs_length;
+        }
+        run = &glyph_runs[index - 1];
+        run->id = id;
+        run->textLength = -1;
+        run->nextIndex = *bucket;
+        *bucket = index;
+    }
+    run->generation = glyph_run_generation;
+    if (run->textHash != textHash || run->textLength != text.length || run->fontId != fontId || run->textureId != font.texture.id || run->fontSize != fontSize
+        || run->letterSpacing != letterSpacing || (run->usesAtlas && run->atlasEpoch != glyph_atlas_epoch)) {
+        run->textHash = textHash;
+        run->textLength = text.length;
+        run->fontId = fontId;
+        run->textureId = font.texture.id;
+        run->fontSize = fontSize;
+        run->letterSpacing = letterSpacing;
+        Clay_Raylib__BuildGlyphRun(run, fontId, font, text, fontSize, letterSpacing);
+        // Set after building, since building can itself evict a page
+        run->atlasEpoch = glyph_atlas_epoch;
+    }
+    return run;
 }
 
+// Evicts glyph runs that haven't been drawn recently, called once per frame
+static void Clay_Raylib__EvictGlyphRuns(void)
+{
+    glyph_run_generation++;
+    for (int i = 0; i < CLAY_RAYLIB_GLYPH_RUN_BUCKETS; i++) {
+        int *link = &glyph_run_buckets[i];
+        while (*link) {
+            int index = *link;
+            Clay_Raylib__GlyphRun *run = &glyph_runs[index - 1];
+            if (glyph_run_generation - run->generation > CLAY_RAYLIB_GLYPH_RUN_MAX_AGE) {
+                *link = run->nextIndex;
+                run->nextIndex = glyph_run_free_list;
+                glyph_run_free_list = index;
+            } else {
+                link = &run->nextIndex;
+            }
+        }
+    }
+}
+
+// Draws a line of text from its cached glyph run, writing one quad per glyph into rlgl's batch.
+// Unchanged text, even if it moved, is only hashed and copied rather than decoded and laid out again.
+static void Clay_Raylib__DrawText(uint32_t id, int fontId, Font font, Clay_StringSlice text, Vector2 position, float fontSize, float letterSpacing, Color color)
+{
+    if (font.texture.id == 0) font = GetFontDefault();
+    Clay_Raylib__GlyphRun *run = Clay_Raylib__GetGlyphRun(id, fontId, font, text, fontSize, letterSpacing);
+    if (run->quadCount == 0) return;
+
+    // Switches texture wherever consecutive glyphs come from different atlas pages
+    int page = -2;
+    for (int quad = 0; quad < run->quadCount; quad++) {
+        if (run->pages[quad] != page) {
+            if (page != -2) {
+                rlEnd();
+                // Sorting only sees the texture the text starts with, see Clay_Raylib__TextureKey()
+                batch_stats.drawCalls++;
+            }
+            page = run->pages[quad];
+            rlSetTexture(page < 0 ? font.texture.id : Clay_Raylib__UseGlyphPage(page));
+            rlBegin(RL_QUADS);
+            rlColor4ub(color.r, color.g, color.b, color.a);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+        }
+        for (int i = quad * 8; i < quad * 8 + 8; i += 2) {
+            rlTexCoord2f(run->texcoords[i], run->texcoords[i + 1]);
+            rlVertex2f(position.x + run->positions[i], position.y + run->positions[i + 1]);
+        }
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+static void Clay_Raylib__DrawImage(Texture2D imageTexture, Clay_BoundingBox boundingBox, Color tintColor)
+{
+    if (tintColor.r == 0 && tintColor.g == 0 && tintColor.b == 0 && tintColor.a == 0) {
+        tintColor = WHITE;
+    }
+    DrawTextureEx(
+        imageTexture,
+        (Vector2){boundingBox.x, boundingBox.y},
+        0,
+        boundingBox.width / (float)imageTexture.width,
+        tintColor);
+}
+
+static inline float Clay_Raylib__PackByte(float value)
+{
+    return fminf(fmaxf(roundf(value), 0), 255);
+}
+
+// Points the instance attributes at the instances starting from firstInstance in the instance buffer
+static void Clay_Raylib__SetShapeInstanceAttributes(int firstInstance)
+{
+    int stride = sizeof(Clay_Raylib__ShapeInstance);
+    int offset = firstInstance * stride;
+    rlEnableVertexBuffer(shape_instance_buffer);
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 4, RL_FLOAT, false, stride, offset + offsetof(Clay_Raylib__ShapeInstance, x));
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 4, RL_UNSIGNED_BYTE, false, stride, offset + offsetof(Clay_Raylib__ShapeInstance, cornerRadius));
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, 4, RL_UNSIGNED_BYTE, false, stride, offset + offsetof(Clay_Raylib__ShapeInstance, borderWidth));
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, stride, offset + offsetof(Clay_Raylib__ShapeInstance, r));
+}
+
+static void Clay_Raylib__LoadShapeInstancing(void)
+{
+    Shader shader = LoadShaderFromMemory(shape_vertex_shader, shape_fragment_shader);
+    // raylib falls back to its default shader when compilation fails
+    if (shader.id == rlGetShaderIdDefault()) return;
+    shape_shader = shader;
+    // Two triangles covering the unit square, scaled to each instance's bounding box
+    static const float corners[12] = { 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0 };
+    shape_vertex_array = rlLoadVertexArray();
+    rlEnableVertexArray(shape_vertex_array);
+    shape_corner_buffer = rlLoadVertexBuffer(corners, sizeof(corners), false);
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+    rlDisableVertexArray();
+}
+
+// Grows the instance buffer, along with the vertex array's attributes that read from it
+static void Clay_Raylib__ReserveShapeInstanceBuffer(int capacity)
+{
+    if (capacity <= shape_instance_buffer_capacity) return;
+    if (shape_instance_buffer) rlUnloadVertexBuffer(shape_instance_buffer);
+    shape_instance_buffer_capacity = capacity;
+    rlEnableVertexArray(shape_vertex_array);
+    shape_instance_buffer = rlLoadVertexBuffer(NULL, capacity * sizeof(Clay_Raylib__ShapeInstance), true);
+    Clay_Raylib__SetShapeInstanceAttributes(0);
+    rlSetVertexAttributeDivisor(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 1);
+    rlSetVertexAttributeDivisor(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 1);
+    rlSetVertexAttributeDivisor(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, 1);
+    rlSetVertexAttributeDivisor(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 1);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+    rlDisableVertexArray();
+    // The new buffer holds none of this frame's earlier instances
+    shape_instance_buffer_cursor = 0;
+}
+
+static void Clay_Raylib__AddShapeInstance(Clay_Raylib__ShapeInstance instance)
+{
+    if (shape_instances_length == shape_instances_capacity) {
+        shape_instances_capacity = shape_instances_capacity ? shape_instances_capacity * 2 : 1024;
+        shape_instances = realloc(shape_instances, shape_instances_capacity * sizeof(Clay_Raylib__ShapeInstance));
+    }
+    shape_instances[shape_instances_length++] = instance;
+}
+
+// Rectangles and borders are gathered as shape instances, everything else draws the gathered shapes first
+static inline bool Clay_Raylib__IsShapeCommand(Clay_RenderCommandType commandType) {
+    return commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE || commandType == CLAY_RENDER_COMMAND_TYPE_BORDER;
+}
+
+// Draws the gathered shapes with one instanced draw call. Called before drawing anything else, to keep painter's order.
+static void Clay_Raylib__FlushShapeInstances(void)
+{
+    if (shape_instances_length == 0) return;
+    // Draw whatever rlgl has batched first, since instanced draws go straight to the GPU
+    rlDrawRenderBatchActive();
+    if (shape_instance_buffer_cursor + shape_instances_length > shape_instance_buffer_capacity) {
+        Clay_Raylib__ReserveShapeInstanceBuffer(CLAY__MAX(shape_instance_buffer_capacity * 2, shape_instance_buffer_cursor + shape_instances_length));
+    }
+    int instanceSize = sizeof(Clay_Raylib__ShapeInstance);
+    rlUpdateVertexBuffer(shape_instance_buffer, shape_instances, shape_instances_length * instanceSize, shape_instance_buffer_cursor * instanceSize);
+    rlEnableShader(shape_shader.id);
+    rlSetUniformMatrix(shape_shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    rlEnableVertexArray(shape_vertex_array);
+    Clay_Raylib__SetShapeInstanceAttributes(shape_instance_buffer_cursor);
+    rlDrawVertexArrayInstanced(0, 6, shape_instances_length);
+    rlDisableVertexArray();
+    rlDisableShader();
+    shape_instance_buffer_cursor += shape_instances_length;
+    shape_instances_length = 0;
+}
+
+static void Clay_Raylib__DrawRectangle(Clay_BoundingBox boundingBox, Clay_CornerRadius cornerRadius, Color color)
+{
+    bool rounded = cornerRadius.topLeft > 0 || cornerRadius.topRight > 0 || cornerRadius.bottomLeft > 0 || cornerRadius.bottomRight > 0;
+    if (shape_shader.id) {
+        if (!rounded) {
+            // Snapped to whole pixels in the same way as DrawRectangle()
+            boundingBox = (Clay_BoundingBox) { (float)(int)boundingBox.x, (float)(int)boundingBox.y, (float)(int)boundingBox.width, (float)(int)boundingBox.height };
+        }
+        Clay_Raylib__AddShapeInstance((Clay_Raylib__ShapeInstance) {
+            boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height,
+            { Clay_Raylib__PackByte(cornerRadius.topLeft), Clay_Raylib__PackByte(cornerRadius.topRight), Clay_Raylib__PackByte(cornerRadius.bottomLeft), Clay_Raylib__PackByte(cornerRadius.bottomRight) },
+            { 0 },
+            color.r, color.g, color.b, color.a
+        });
+    } else if (cornerRadius.topLeft > 0) {
+        float radius = (cornerRadius.topLeft * 2) / (float)((boundingBox.width > boundingBox.height) ? boundingBox.height : boundingBox.width);
+        DrawRectangleRounded((Rectangle) { boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height }, radius, 8, color);
+    } else {
+        DrawRectangle(boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height, color);
+    }
+}
+
+static void Clay_Raylib__DrawBorder(Clay_BoundingBox boundingBox, Clay_BorderWidth width, Clay_CornerRadius cornerRadius, Color color)
+{
+    if (shape_shader.id) {
+        if (width.left > 0 || width.right > 0 || width.top > 0 || width.bottom > 0) {
+            Clay_Raylib__AddShapeInstance((Clay_Raylib__ShapeInstance) {
+                boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height,
+                { Clay_Raylib__PackByte(cornerRadius.topLeft), Clay_Raylib__PackByte(cornerRadius.topRight), Clay_Raylib__PackByte(cornerRadius.bottomLeft), Clay_Raylib__PackByte(cornerRadius.bottomRight) },
+                { Clay_Raylib__PackByte(width.left), Clay_Raylib__PackByte(width.right), Clay_Raylib__PackByte(width.top), Clay_Raylib__PackByte(width.bottom) },
+                color.r, color.g, color.b, color.a
+            });
+        }
+        return;
+    }
+    // Left border
+    if (width.left > 0) {
+        DrawRectangle((int)roundf(boundingBox.x), (int)roundf(boundingBox.y + cornerRadius.topLeft), (int)width.left, (int)roundf(boundingBox.height - cornerRadius.topLeft - cornerRadius.bottomLeft), color);
+    }
+    // Right border
+    if (width.right > 0) {
+        DrawRectangle((int)roundf(boundingBox.x + boundingBox.width - width.right), (int)roundf(boundingBox.y + cornerRadius.topRight), (int)width.right, (int)roundf(boundingBox.height - cornerRadius.topRight - cornerRadius.bottomRight), color);
+    }
+    // Top border
+    if (width.top > 0) {
+        DrawRectangle((int)roundf(boundingBox.x + cornerRadius.topLeft), (int)roundf(boundingBox.y), (int)roundf(boundingBox.width - cornerRadius.topLeft - cornerRadius.topRight), (int)width.top, color);
+    }
+    // Bottom border
+    if (width.bottom > 0) {
+        DrawRectangle((int)roundf(boundingBox.x + cornerRadius.bottomLeft), (int)roundf(boundingBox.y + boundingBox.height - width.bottom), (int)roundf(boundingBox.width - cornerRadius.bottomLeft - cornerRadius.bottomRight), (int)width.bottom, color);
+    }
+    if (cornerRadius.topLeft > 0) {
+        DrawRing((Vector2) { roundf(boundingBox.x + cornerRadius.topLeft), roundf(boundingBox.y + cornerRadius.topLeft) }, roundf(cornerRadius.topLeft - width.top), cornerRadius.topLeft, 180, 270, 10, color);
+    }
+    if (cornerRadius.topRight > 0) {
+        DrawRing((Vector2) { roundf(boundingBox.x + boundingBox.width - cornerRadius.topRight), roundf(boundingBox.y + cornerRadius.topRight) }, roundf(cornerRadius.topRight - width.top), cornerRadius.topRight, 270, 360, 10, color);
+    }
+    if (cornerRadius.bottomLeft > 0) {
+        DrawRing((Vector2) { roundf(boundingBox.x + cornerRadius.bottomLeft), roundf(boundingBox.y + boundingBox.height - cornerRadius.bottomLeft) }, roundf(cornerRadius.bottomLeft - width.top), cornerRadius.bottomLeft, 90, 180, 10, color);
+    }
+    if (cornerRadius.bottomRight > 0) {
+        DrawRing((Vector2) { roundf(boundingBox.x + boundingBox.width - cornerRadius.bottomRight), roundf(boundingBox.y + boundingBox.height - cornerRadius.bottomRight) }, roundf(cornerRadius.bottomRight - width.bottom), cornerRadius.bottomRight, 0.1, 90, 10, color);
+    }
+}
+
+// rootBox is the bounding box of the first render command, which covers the whole layout
+static void Clay_Raylib__DrawCustom(CustomLayoutElement *customElement, Clay_BoundingBox boundingBox, Clay_BoundingBox rootBox)
+{
+    if (!customElement) return;
+    switch (customElement->type) {
+        case CUSTOM_LAYOUT_ELEMENT_TYPE_3D_MODEL: {
+            float scaleValue = CLAY__MIN(CLAY__MIN(1, 768 / rootBox.height) * CLAY__MAX(1, rootBox.width / 1024), 1.5f);
+            Ray positionRay = GetScreenToWorldPointWithZDistance((Vector2) { boundingBox.x + boundingBox.width / 2, boundingBox.y + (boundingBox.height / 2) + 20 }, Raylib_camera, (int)roundf(rootBox.width), (int)roundf(rootBox.height), 140);
+            BeginMode3D(Raylib_camera);
+                DrawModel(customElement->customData.model.model, positionRay.position, customElement->customData.model.scale * scaleValue, WHITE);        // Draw 3d model with texture
+            EndMode3D();
+            break;
+        }
+        default: break;
+    }
+}
+
+static void Clay_Raylib__Scissor(Clay_BoundingBox boundingBox)
+{
+    BeginScissorMode((int)roundf(boundingBox.x * scissor_scale.x), (int)roundf(boundingBox.y * scissor_scale.y), (int)roundf(boundingBox.width * scissor_scale.x), (int)roundf(boundingBox.height * scissor_scale.y));
+}
+
+static void Clay_Raylib__BeginScissor(Clay_BoundingBox boundingBox, const Clay_BoundingBox *clip)
+{
+    if (clip) {
+        boundingBox = Clay_Raylib__BoxIntersection(boundingBox, *clip);
+    }
+    Clay_Raylib__Scissor(boundingBox);
+}
+
+static void Clay_Raylib__EndScissor(const Clay_BoundingBox *clip)
+{
+    if (clip) {
+        Clay_Raylib__Scissor(*clip);
+    } else {
+        EndScissorMode();
+    }
+}
+
+static void Clay_Raylib__RenderCommand(Clay_RenderCommandArray renderCommands, Clay_RenderCommand *renderCommand, Font* fonts, const Clay_BoundingBox *clip)
+{
+    Clay_BoundingBox boundingBox = renderCommand->boundingBox;
+    if (!Clay_Raylib__IsShapeCommand(renderCommand->commandType)) {
+        Clay_Raylib__FlushShapeInstances();
+    }
+    switch (renderCommand->commandType)
+    {
+        case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+            Clay_TextRenderData *textData = &renderCommand->renderData.text;
+            Clay_Raylib__DrawText(renderCommand->id, textData->fontId, fonts[textData->fontId], textData->stringContents, (Vector2){boundingBox.x, boundingBox.y}, (float)textData->fontSize, (float)textData->letterSpacing, CLAY_COLOR_TO_RAYLIB_COLOR(textData->textColor));
+            break;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+            Clay_ImageRenderData *config = &renderCommand->renderData.image;
+            Clay_Raylib__DrawImage(*(Texture2D *)config->imageData, boundingBox, CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
+            break;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
+            Clay_Raylib__BeginScissor(boundingBox, clip);
+            break;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
+            Clay_Raylib__EndScissor(clip);
+            break;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+            Clay_RectangleRenderData *config = &renderCommand->renderData.rectangle;
+            // Clay's colors are within 0-255, so adding 0.5 and truncating rounds them without the four calls to roundf()
+            Clay_Color backgroundColor = config->backgroundColor;
+            Color color = { (unsigned char)(backgroundColor.r + 0.5f), (unsigned char)(backgroundColor.g + 0.5f), (unsigned char)(backgroundColor.b + 0.5f), (unsigned char)(backgroundColor.a + 0.5f) };
+            Clay_Raylib__DrawRectangle(boundingBox, config->cornerRadius, color);
+            break;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+            Clay_BorderRenderData *config = &renderCommand->renderData.border;
+            Clay_Raylib__DrawBorder(boundingBox, config->width, config->cornerRadius, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
+            break;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
+            Clay_Raylib__DrawCustom((CustomLayoutElement *)renderCommand->renderData.custom.customData, boundingBox, renderCommands.internalArray[0].boundingBox);
+            break;
+        }
+        default: {
+            printf("Error: unhandled render command.");
+            exit(1);
+        }
+    }
+}
+
+// Scissor changes flush rlgl's batch themselves, and custom elements switch to 3D mode, so commands are never moved across them
+static inline bool Clay_Raylib__IsBatchBarrier(Clay_RenderCommandType commandType) {
+    return commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START || commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END || commandType == CLAY_RENDER_COMMAND_TYPE_CUSTOM;
+}
+
+// Atlas pages are keyed apart from texture ids, since their textures are only created once they're first drawn from
+static inline unsigned int Clay_Raylib__GlyphPageKey(int page)
+{
+    return 0xFFFFFFFFu - (unsigned int)page;
+}
+
+// The texture rlgl will bind first to draw the command. Switching textures starts a new draw call in the batch.
+static unsigned int Clay_Raylib__TextureKey(Clay_RenderCommand *renderCommand, Font* fonts)
+{
+    switch (renderCommand->commandType) {
+        case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+            // Text starts with the texture of its first glyph, which can be an atlas page. Until its run is cached, the font's texture is assumed.
+            Clay_Raylib__GlyphRun *run = Clay_Raylib__FindGlyphRun(renderCommand->id);
+            if (run && run->quadCount > 0 && run->pages[0] >= 0) return Clay_Raylib__GlyphPageKey(run->pages[0]);
+            unsigned int textureId = fonts[renderCommand->renderData.text.fontId].texture.id;
+            // DrawTextEx() falls back to the default font for fonts that failed to load
+            return textureId ? textureId : GetFontDefault().texture.id;
+        }
+        case CLAY_RENDER_COMMAND_TYPE_IMAGE: return ((Texture2D *)renderCommand->renderData.image.imageData)->id;
+        // Instanced shapes bind no texture, and are grouped under a key no texture uses
+        case CLAY_RENDER_COMMAND_TYPE_RECTANGLE:
+        case CLAY_RENDER_COMMAND_TYPE_BORDER: return shape_shader.id ? 0 : GetShapesTexture().id;
+        default: return GetShapesTexture().id;
+    }
+}
+
+// How many commands a batch can be moved ahead of. Bounds the cost of sorting long runs.
+#define CLAY_RAYLIB_BATCH_LOOKAHEAD 32
+
+// Orders the run in batch_pending into batch_order, grouping commands by texture. A command is only moved ahead of commands it doesn't overlap,
+// so painter's order (and with it zIndex, which Clay applies when ordering the commands) is preserved wherever it is visible. Returns the number of batches.
+static int Clay_Raylib__SortBatchRun(Clay_RenderCommandArray renderCommands, int runLength)
+{
+    int ordered = 0;
+    int batches = 0;
+    while (runLength > 0) {
+        unsigned int key = batch_keys[0];
+        Clay_BoundingBox skipped[CLAY_RAYLIB_BATCH_LOOKAHEAD];
+        int skippedCount = 0;
+        int kept = 0;
+        int i = 0;
+        for (; i < runLength && skippedCount < CLAY_RAYLIB_BATCH_LOOKAHEAD; i++) {
+            Clay_BoundingBox boundingBox = renderCommands.internalArray[batch_pending[i]].boundingBox;
+            // Anti-aliased edges can reach just past the bounding box
+            boundingBox = (Clay_BoundingBox) { boundingBox.x - 1, boundingBox.y - 1, boundingBox.width + 2, boundingBox.height + 2 };
+            bool blocked = batch_keys[i] != key;
+            for (int k = 0; !blocked && k < skippedCount; k++) {
+                blocked = Clay_Raylib__BoxesOverlap(skipped[k], boundingBox);
+            }
+            if (blocked) {
+                skipped[skippedCount++] = boundingBox;
+                batch_pending[kept] = batch_pending[i];
+                batch_keys[kept++] = batch_keys[i];
+            } else {
+                batch_order[ordered++] = batch_pending[i];
+            }
+        }
+        for (; i < runLength; i++) {
+            batch_pending[kept] = batch_pending[i];
+            batch_keys[kept++] = batch_keys[i];
+        }
+        runLength = kept;
+        batches++;
+    }
+    return batches;
+}
+
+// Draws the render commands. When clip is provided, commands entirely outside it are skipped and all drawing is scissored to it.
+// Between scissor changes, commands are reordered to draw everything using the same texture together, see Clay_Raylib__SortBatchRun().
+static void Clay_Raylib__RenderCommands(Clay_RenderCommandArray renderCommands, Font* fonts, const Clay_BoundingBox *clip)
+{
+    if (renderCommands.length > batch_capacity) {
+        free(batch_pending);
+        free(batch_keys);
+        free(batch_order);
+        batch_capacity = renderCommands.length;
+        batch_pending = malloc(batch_capacity * sizeof(int));
+        batch_keys = malloc(batch_capacity * sizeof(unsigned int));
+        batch_order = malloc(batch_capacity * sizeof(int));
+    }
+    int j = 0;
+    while (j < renderCommands.length)
+    {
+        int runLength = 0;
+        int unsortedBatches = 0;
+        for (; j < renderCommands.length; j++) {
+            Clay_RenderCommand *renderCommand = Clay_RenderCommandArray_Get(&renderCommands, j);
+            if (Clay_Raylib__IsBatchBarrier(renderCommand->commandType)) break;
+            if (clip && !Clay_Raylib__BoxesOverlap(renderCommand->boundingBox, *clip)) continue;
+            batch_pending[runLength] = j;
+            batch_keys[runLength] = Clay_Raylib__TextureKey(renderCommand, fonts);
+            if (runLength == 0 || batch_keys[runLength] != batch_keys[runLength - 1]) unsortedBatches++;
+            runLength++;
+        }
+        int orderedLength = runLength;
+        int batches = Clay_Raylib__SortBatchRun(renderCommands, runLength);
+        batch_stats.drawCalls += batches;
+        batch_stats.drawCallsSaved += unsortedBatches - batches;
+        for (int i = 0; i < orderedLength; i++) {
+            Clay_Raylib__RenderCommand(renderCommands, Clay_RenderCommandArray_Get(&renderCommands, batch_order[i]), fonts, clip);
+        }
+        if (j < renderCommands.length) {
+            Clay_RenderCommand *barrier = Clay_RenderCommandArray_Get(&renderCommands, j++);
+            if (barrier->commandType != CLAY_RENDER_COMMAND_TYPE_CUSTOM || !clip || Clay_Raylib__BoxesOverlap(barrier->boundingBox, *clip)) {
+                Clay_Raylib__RenderCommand(renderCommands, barrier, fonts, clip);
+            }
+        }
+    }
+    Clay_Raylib__FlushShapeInstances();
+}
+
+// Returns the batching statistics of the most recent Clay_Raylib_Render() or Clay_Raylib_RenderDamaged()
+Clay_Raylib_BatchStats Clay_Raylib_GetBatchStats(void)
+{
+    return batch_stats;
+}
+
+static void Clay_Raylib__BeginFrame(void)
+{
+    batch_stats = (Clay_Raylib_BatchStats) { 0 };
+    Clay_Raylib__EvictGlyphRuns();
+    if (!shape_shader_attempted) {
+        shape_shader_attempted = true;
+        Clay_Raylib__LoadShapeInstancing();
+    }
+    shape_instance_buffer_cursor = 0;
+}
 
 void Clay_Raylib_Render(Clay_RenderCommandArray renderCommands, Font* fonts)
 {
-    for (int j = 0; j < renderCommands.length; j++)
+    Clay_Raylib__BeginFrame();
+    Clay_Raylib__RenderCommands(renderCommands, fonts, NULL);
+}
+
+#define CLAY_PACKED_COLOR_TO_RAYLIB_COLOR(color) (Color) { .r = color.r, .g = color.g, .b = color.b, .a = color.a }
+
+// Draws the packed render commands from Clay_GetPackedRenderCommands(). Requires Clay_SetPackedRenderCommandsEnabled(true).
+// Use in place of Clay_Raylib_Render() when the commands are read from the packed stream, e.g. after copying it to a render thread.
+void Clay_Raylib_RenderPacked(Clay_PackedRenderCommandStream stream, Font* fonts)
+{
+    Clay_Raylib__BeginFrame();
+    for (int j = 0; j < stream.length; j++)
     {
-        Clay_RenderCommand *renderCommand = Clay_RenderCommandArray_Get(&renderCommands, j);
-        Clay_BoundingBox boundingBox = renderCommand->boundingBox;
+        Clay_PackedRenderCommand *renderCommand = &stream.commands[j];
+        Clay_BoundingBox boundingBox = { renderCommand->x, renderCommand->y, renderCommand->width, renderCommand->height };
+        Clay_PackedRenderCommandData *data = renderCommand->dataIndex >= 0 ? &stream.data[renderCommand->dataIndex] : NULL;
+        Color color = CLAY_PACKED_COLOR_TO_RAYLIB_COLOR(renderCommand->color);
+        Clay_CornerRadius cornerRadius = { renderCommand->cornerRadius[0], renderCommand->cornerRadius[1], renderCommand->cornerRadius[2], renderCommand->cornerRadius[3] };
+        if (!Clay_Raylib__IsShapeCommand(renderCommand->commandType)) {
+            Clay_Raylib__FlushShapeInstances();
+        }
         switch (renderCommand->commandType)
         {
             case CLAY_RENDER_COMMAND_TYPE_TEXT: {
-                Clay_TextRenderData *textData = &renderCommand->renderData.text;
-                Font fontToUse = fonts[textData->fontId];
-    
-                int strlen = textData->stringContents.length + 1;
-    
-                if(strlen > temp_render_buffer_len) {
-                    // Grow the temp buffer if we need a larger string
-                    if(temp_render_buffer) free(temp_render_buffer);
-                    temp_render_buffer = malloc(strlen);
-                    temp_render_buffer_len = strlen;
-                }
-    
-                // Raylib uses standard C strings so isn't compatible with cheap slices, we need to clone the string to append null terminator
-                memcpy(temp_render_buffer, textData->stringContents.chars, textData->stringContents.length);
-                temp_render_buffer[textData->stringContents.length] = '\0';
-                DrawTextEx(fontToUse, temp_render_buffer, (Vector2){boundingBox.x, boundingBox.y}, (float)textData->fontSize, (float)textData->letterSpacing, CLAY_COLOR_TO_RAYLIB_COLOR(textData->textColor));
-    
+                Clay_Raylib__DrawText(renderCommand->id, renderCommand->renderData.text.fontId, fonts[renderCommand->renderData.text.fontId], data->stringContents, (Vector2){boundingBox.x, boundingBox.y}, (float)renderCommand->renderData.text.fontSize, (float)data->letterSpacing, color);
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
-                Texture2D imageTexture = *(Texture2D *)renderCommand->renderData.image.imageData;
-                Clay_Color tintColor = renderCommand->renderData.image.backgroundColor;
-                if (tintColor.r == 0 && tintColor.g == 0 && tintColor.b == 0 && tintColor.a == 0) {
-                    tintColor = (Clay_Color) { 255, 255, 255, 255 };
-                }
-                DrawTextureEx(
-                    imageTexture,
-                    (Vector2){boundingBox.x, boundingBox.y},
-                    0,
-                    boundingBox.width / (float)imageTexture.width,
-                    CLAY_COLOR_TO_RAYLIB_COLOR(tintColor));
+                Clay_Raylib__DrawImage(*(Texture2D *)data->data, boundingBox, color);
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
-                BeginScissorMode((int)roundf(boundingBox.x), (int)roundf(boundingBox.y), (int)roundf(boundingBox.width), (int)roundf(boundingBox.height));
+                Clay_Raylib__BeginScissor(boundingBox, NULL);
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
-                EndScissorMode();
+                Clay_Raylib__EndScissor(NULL);
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
-                Clay_RectangleRenderData *config = &renderCommand->renderData.rectangle;
-                if (config->cornerRadius.topLeft > 0) {
-                    float radius = (config->cornerRadius.topLeft * 2) / (float)((boundingBox.width > boundingBox.height) ? boundingBox.height : boundingBox.width);
-                    DrawRectangleRounded((Rectangle) { boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height }, radius, 8, CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
-                } else {
-                    DrawRectangle(boundingBox.x, boundingBox.y, boundingBox.width, boundingBox.height, CLAY_COLOR_TO_RAYLIB_COLOR(config->backgroundColor));
-                }
+                Clay_Raylib__DrawRectangle(boundingBox, cornerRadius, color);
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_BORDER: {
-                Clay_BorderRenderData *config = &renderCommand->renderData.border;
-                // Left border
-                if (config->width.left > 0) {
-                    DrawRectangle((int)roundf(boundingBox.x), (int)roundf(boundingBox.y + config->cornerRadius.topLeft), (int)config->width.left, (int)roundf(boundingBox.height - config->cornerRadius.topLeft - config->cornerRadius.bottomLeft), CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                // Right border
-                if (config->width.right > 0) {
-                    DrawRectangle((int)roundf(boundingBox.x + boundingBox.width - config->width.right), (int)roundf(boundingBox.y + config->cornerRadius.topRight), (int)config->width.right, (int)roundf(boundingBox.height - config->cornerRadius.topRight - config->cornerRadius.bottomRight), CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                // Top border
-                if (config->width.top > 0) {
-                    DrawRectangle((int)roundf(boundingBox.x + config->cornerRadius.topLeft), (int)roundf(boundingBox.y), (int)roundf(boundingBox.width - config->cornerRadius.topLeft - config->cornerRadius.topRight), (int)config->width.top, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                // Bottom border
-                if (config->width.bottom > 0) {
-                    DrawRectangle((int)roundf(boundingBox.x + config->cornerRadius.bottomLeft), (int)roundf(boundingBox.y + boundingBox.height - config->width.bottom), (int)roundf(boundingBox.width - config->cornerRadius.bottomLeft - config->cornerRadius.bottomRight), (int)config->width.bottom, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                if (config->cornerRadius.topLeft > 0) {
-                    DrawRing((Vector2) { roundf(boundingBox.x + config->cornerRadius.topLeft), roundf(boundingBox.y + config->cornerRadius.topLeft) }, roundf(config->cornerRadius.topLeft - config->width.top), config->cornerRadius.topLeft, 180, 270, 10, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                if (config->cornerRadius.topRight > 0) {
-                    DrawRing((Vector2) { roundf(boundingBox.x + boundingBox.width - config->cornerRadius.topRight), roundf(boundingBox.y + config->cornerRadius.topRight) }, roundf(config->cornerRadius.topRight - config->width.top), config->cornerRadius.topRight, 270, 360, 10, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                if (config->cornerRadius.bottomLeft > 0) {
-                    DrawRing((Vector2) { roundf(boundingBox.x + config->cornerRadius.bottomLeft), roundf(boundingBox.y + boundingBox.height - config->cornerRadius.bottomLeft) }, roundf(config->cornerRadius.bottomLeft - config->width.top), config->cornerRadius.bottomLeft, 90, 180, 10, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
-                if (config->cornerRadius.bottomRight > 0) {
-                    DrawRing((Vector2) { roundf(boundingBox.x + boundingBox.width - config->cornerRadius.bottomRight), roundf(boundingBox.y + boundingBox.height - config->cornerRadius.bottomRight) }, roundf(config->cornerRadius.bottomRight - config->width.bottom), config->cornerRadius.bottomRight, 0.1, 90, 10, CLAY_COLOR_TO_RAYLIB_COLOR(config->color));
-                }
+                Clay_BorderWidth width = { .left = renderCommand->renderData.borderWidth[0], .right = renderCommand->renderData.borderWidth[1], .top = renderCommand->renderData.borderWidth[2], .bottom = renderCommand->renderData.borderWidth[3] };
+                Clay_Raylib__DrawBorder(boundingBox, width, cornerRadius, color);
                 break;
             }
             case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
-                Clay_CustomRenderData *config = &renderCommand->renderData.custom;
-                CustomLayoutElement *customElement = (CustomLayoutElement *)config->customData;
-                if (!customElement) continue;
-                switch (customElement->type) {
-                    case CUSTOM_LAYOUT_ELEMENT_TYPE_3D_MODEL: {
-                        Clay_BoundingBox rootBox = renderCommands.internalArray[0].boundingBox;
-                        float scaleValue = CLAY__MIN(CLAY__MIN(1, 768 / rootBox.height) * CLAY__MAX(1, rootBox.width / 1024), 1.5f);
-                        Ray positionRay = GetScreenToWorldPointWithZDistance((Vector2) { renderCommand->boundingBox.x + renderCommand->boundingBox.width / 2, renderCommand->boundingBox.y + (renderCommand->boundingBox.height / 2) + 20 }, Raylib_camera, (int)roundf(rootBox.width), (int)roundf(rootBox.height), 140);
-                        BeginMode3D(Raylib_camera);
-                            DrawModel(customElement->customData.model.model, positionRay.position, customElement->customData.model.scale * scaleValue, WHITE);        // Draw 3d model with texture
-                        EndMode3D();
-                        break;
-                    }
-                    default: break;
-                }
+                Clay_PackedRenderCommand *root = &stream.commands[0];
+                Clay_Raylib__DrawCustom(data ? (CustomLayoutElement *)data->data : NULL, boundingBox, (Clay_BoundingBox) { root->x, root->y, root->width, root->height });
                 break;
             }
             default: {
@@ -257,4 +1263,142 @@ void Clay_Raylib_Render(Clay_RenderCommandArray renderCommands, Font* fonts)
             }
         }
     }
+    Clay_Raylib__FlushShapeInstances();
+}
+
+#define CLAY_RAYLIB_MAX_DAMAGE_RECTS 8
+// Drawing isn't exactly confined to bounding boxes (rounding, anti-aliased edges), so damage is grown by a few pixels
+#define CLAY_RAYLIB_DAMAGE_PADDING 2
+
+typedef struct
+{
+    Clay_BoundingBox rects[CLAY_RAYLIB_MAX_DAMAGE_RECTS];
+    int count;
+} Clay_Raylib__Damage;
+
+static void Clay_Raylib__AddDamage(Clay_Raylib__Damage *damage, Clay_BoundingBox box, Clay_BoundingBox screen)
+{
+    box = (Clay_BoundingBox) { floorf(box.x) - CLAY_RAYLIB_DAMAGE_PADDING, floorf(box.y) - CLAY_RAYLIB_DAMAGE_PADDING, ceilf(box.width) + CLAY_RAYLIB_DAMAGE_PADDING * 2 + 1, ceilf(box.height) + CLAY_RAYLIB_DAMAGE_PADDING * 2 + 1 };
+    box = Clay_Raylib__BoxIntersection(box, screen);
+    if (box.width <= 0 || box.height <= 0) return;
+    for (int i = 0; i < damage->count; i++) {
+        if (Clay_Raylib__BoxesOverlap(damage->rects[i], box)) {
+            damage->rects[i] = Clay_Raylib__BoxUnion(damage->rects[i], box);
+            return;
+        }
+    }
+    if (damage->count < CLAY_RAYLIB_MAX_DAMAGE_RECTS) {
+        damage->rects[damage->count++] = box;
+        return;
+    }
+    // Out of rects, so merge into whichever one grows the least
+    int best = 0;
+    float bestGrowth = INFINITY;
+    for (int i = 0; i < damage->count; i++) {
+        Clay_BoundingBox merged = Clay_Raylib__BoxUnion(damage->rects[i], box);
+        float growth = merged.width * merged.height - damage->rects[i].width * damage->rects[i].height;
+        if (growth < bestGrowth) {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    damage->rects[best] = Clay_Raylib__BoxUnion(damage->rects[best], box);
+}
+
+static void Clay_Raylib__AddDamageForCommands(Clay_Raylib__Damage *damage, Clay_RenderCommandArray commands, Clay_BoundingBox screen)
+{
+    for (int i = 0; i < commands.length; i++) {
+        Clay_RenderCommandType commandType = commands.internalArray[i].commandType;
+        // Scissors draw nothing themselves. Commands added or removed inside them are reported in full, see Clay_Raylib__AddDamageForScissors().
+        if (commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START || commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END) continue;
+        Clay_Raylib__AddDamage(damage, commands.internalArray[i].boundingBox, screen);
+    }
+}
+
+// A scissor that moved or resized clips its contents differently even where they didn't change, so everything within its old and new clip is redrawn.
+// Scissor ends have no bounding box, they end the clip of their matching start.
+static void Clay_Raylib__AddDamageForScissors(Clay_Raylib__Damage *damage, Clay_RenderCommandDiff diff, Clay_BoundingBox screen)
+{
+    for (int i = 0; i < diff.changed.length; i++) {
+        Clay_RenderCommand *renderCommand = &diff.changed.internalArray[i];
+        if (renderCommand->commandType != CLAY_RENDER_COMMAND_TYPE_SCISSOR_START) continue;
+        Clay_Raylib__AddDamage(damage, Clay_Raylib__BoxUnion(renderCommand->boundingBox, diff.changedPrevious.internalArray[i].boundingBox), screen);
+    }
+}
+
+// Custom elements, such as 3D models, can animate without their render commands changing, so they're redrawn every frame
+static void Clay_Raylib__AddDamageForCustom(Clay_Raylib__Damage *damage, Clay_RenderCommandArray commands, Clay_BoundingBox screen)
+{
+    for (int i = 0; i < commands.length; i++) {
+        if (commands.internalArray[i].commandType == CLAY_RENDER_COMMAND_TYPE_CUSTOM) {
+            Clay_Raylib__AddDamage(damage, commands.internalArray[i].boundingBox, screen);
+        }
+    }
+}
+
+// Draws only the parts of the window that changed since the previous frame, keeping the last frame in a persistent render texture
+// and copying it to the screen. Requires Clay_SetRenderCommandDiffEnabled(true), otherwise every frame is drawn in full.
+// Frames dropped by Clay's adaptive memory, see Clay_WasLayoutDropped(), show the last frame that was drawn.
+// The render texture has the window's render resolution, so high DPI displays are drawn at full resolution. It isn't multisampled though:
+// the shape shader antialiases rounded shapes itself, but without it, FLAG_MSAA_4X_HINT is honoured by drawing straight to the window in full.
+// Call between BeginDrawing() and EndDrawing() in place of ClearBackground() and Clay_Raylib_Render().
+void Clay_Raylib_RenderDamaged(Clay_RenderCommandArray renderCommands, Font* fonts, Color clearColor)
+{
+    int screenWidth = GetScreenWidth();
+    int screenHeight = GetScreenHeight();
+    int renderWidth = GetRenderWidth();
+    int renderHeight = GetRenderHeight();
+    Clay_BoundingBox screen = { 0, 0, (float)screenWidth, (float)screenHeight };
+    Clay_Raylib__Damage damage = { 0 };
+    Clay_Raylib__BeginFrame();
+
+    if (IsWindowState(FLAG_MSAA_4X_HINT) && !shape_shader.id) {
+        if (damage_render_target.id) UnloadRenderTexture(damage_render_target);
+        damage_render_target = (RenderTexture2D) { 0 };
+        // There's no last frame to show for a dropped one, and clearing would flash, so the window keeps what it has
+        if (!Clay_WasLayoutDropped()) {
+            ClearBackground(clearColor);
+            Clay_Raylib__RenderCommands(renderCommands, fonts, NULL);
+        }
+        return;
+    }
+
+    if (Clay_WasLayoutDropped()) {
+        // Nothing was laid out, and the next frame's diff is relative to the last one drawn, so the render texture is left as it is
+    } else if (!damage_render_target.id || damage_render_target.texture.width != renderWidth || damage_render_target.texture.height != renderHeight) {
+        if (damage_render_target.id) UnloadRenderTexture(damage_render_target);
+        damage_render_target = LoadRenderTexture(renderWidth, renderHeight);
+        damage.rects[damage.count++] = screen;
+    } else if (!Clay_IsRenderCommandDiffEnabled()) {
+        damage.rects[damage.count++] = screen;
+    } else {
+        Clay_RenderCommandDiff diff = Clay_GetRenderCommandDiff();
+        Clay_Raylib__AddDamageForCommands(&damage, diff.added, screen);
+        Clay_Raylib__AddDamageForCommands(&damage, diff.changed, screen);
+        Clay_Raylib__AddDamageForCommands(&damage, diff.changedPrevious, screen);
+        Clay_Raylib__AddDamageForCommands(&damage, diff.removed, screen);
+        Clay_Raylib__AddDamageForScissors(&damage, diff, screen);
+        Clay_Raylib__AddDamageForCustom(&damage, renderCommands, screen);
+    }
+
+    if (damage.count > 0) {
+        BeginTextureMode(damage_render_target);
+        // Map Clay's coordinates onto the whole render texture, in place of the pixel coordinates BeginTextureMode() sets up
+        rlMatrixMode(RL_PROJECTION);
+        rlLoadIdentity();
+        rlOrtho(0, screenWidth, screenHeight, 0, 0.0f, 1.0f);
+        rlMatrixMode(RL_MODELVIEW);
+        scissor_scale = (Vector2) { (float)renderWidth / (float)screenWidth, (float)renderHeight / (float)screenHeight };
+        for (int i = 0; i < damage.count; i++) {
+            Clay_Raylib__Scissor(damage.rects[i]);
+            ClearBackground(clearColor); // Clearing respects the scissor
+            Clay_Raylib__RenderCommands(renderCommands, fonts, &damage.rects[i]);
+            EndScissorMode();
+        }
+        scissor_scale = (Vector2) { 1, 1 };
+        EndTextureMode();
+    }
+    // Render textures are stored upside down
+    Rectangle source = { 0, 0, (float)damage_render_target.texture.width, -(float)damage_render_target.texture.height };
+    DrawTexturePro(damage_render_target.texture, source, (Rectangle) { 0, 0, (float)screenWidth, (float)screenHeight }, (Vector2) { 0, 0 }, 0, WHITE);
 }
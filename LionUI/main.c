@@ -4,9 +4,14 @@
 #include "clay-video-demo.c"
 #include "resource_dir.h"
 
+bool clayCapacityExceeded = false;
+
 // This function is new since the video was published
 void HandleClayErrors(Clay_ErrorData errorData) {
     printf("%s", errorData.errorText.chars);
+    if (errorData.errorType == CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED) {
+        clayCapacityExceeded = true;
+    }
 }
 
 int main(void) {
@@ -21,7 +26,17 @@ int main(void) {
     Font fonts[1];
     fonts[FONT_ID_BODY_16] = LoadFontEx("CascadiaCode-Regular.ttf", 48, 0, 400);
     SetTextureFilter(fonts[FONT_ID_BODY_16].texture, TEXTURE_FILTER_BILINEAR);
+    // Codepoints past the 400 loaded above are rasterized when first used
+    Clay_Raylib_LoadDynamicGlyphs(FONT_ID_BODY_16, "CascadiaCode-Regular.ttf");
     Clay_SetMeasureTextFunction(Raylib_MeasureText, fonts);
+    Clay_SetRetainedLayoutEnabled(true);
+    Clay_SetRenderCommandDiffEnabled(true);
+    // Opt-in features only reserve their memory once the context is resized with them enabled
+    void *initialMemory = clayMemory.memory;
+    clayRequiredMemory = Clay_MinMemorySize();
+    clayMemory = Clay_CreateArenaWithCapacityAndMemory(clayRequiredMemory, malloc(clayRequiredMemory));
+    Clay_ResizeContext(clayMemory);
+    free(initialMemory);
 
     ClayVideoDemo_Data data = ClayVideoDemo_Initialize();
 
@@ -44,11 +59,23 @@ int main(void) {
             GetFrameTime()
         );
 
+        // Grow Clay's capacity between frames, keeping its cached state, if the last layout didn't fit
+        if (clayCapacityExceeded) {
+            clayCapacityExceeded = false;
+            Clay_SetMaxElementCount(Clay_GetMaxElementCount() * 2);
+            Clay_SetMaxMeasureTextCacheWordCount(Clay_GetMaxMeasureTextCacheWordCount() * 2);
+            void *previousMemory = clayMemory.memory;
+            clayRequiredMemory = Clay_MinMemorySize();
+            clayMemory = Clay_CreateArenaWithCapacityAndMemory(clayRequiredMemory, malloc(clayRequiredMemory));
+            Clay_ResizeContext(clayMemory);
+            free(previousMemory);
+        }
+
         Clay_RenderCommandArray renderCommands = ClayVideoDemo_CreateLayout(&data);
 
         BeginDrawing();
-        ClearBackground(BLACK);
-        Clay_Raylib_Render(renderCommands, fonts);
+        // Only redraws the regions that changed since the last frame
+        Clay_Raylib_RenderDamaged(renderCommands, fonts, BLACK);
         EndDrawing();
     }
     // This function is new since the video was published